@@ -20,6 +20,12 @@
 /* Based on public domain implementation from
    https://git.musl-libc.org/cgit/musl/tree/src/crypt/crypt_sha256.c */
 
+#if (defined(__i386__) || defined(__x86_64__)) && defined(__GNUC__)
+#include <immintrin.h>
+#include <intrin.h>
+#define HAVE_SHA_NI
+#endif
+
 #include "bcrypt_internal.h"
 
 static DWORD ror(DWORD n, int k) { return (n >> k) | (n << (32-k)); }
@@ -91,6 +97,102 @@ static void processblock(SHA256_CTX *ctx, const UCHAR *buffer)
     ctx->h[7] += h;
 }
 
+static void processblocks_c(SHA256_CTX *ctx, const UCHAR *buffer, ULONG count)
+{
+    for (; count; count--, buffer += 64)
+        processblock(ctx, buffer);
+}
+
+#ifdef HAVE_SHA_NI
+
+/* four rounds, m0..m3 hold the message words of rounds i - 16 to i - 1 */
+#define SHA_NI_ROUNDS(i, m0, m1, m2, m3) \
+    do { \
+        if ((i) >= 4) \
+            m0 = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(m0, m1), \
+                                                    _mm_alignr_epi8(m3, m2, 4)), m3); \
+        msg = _mm_add_epi32(m0, _mm_loadu_si128((const __m128i *)&K[4 * (i)])); \
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg); \
+        state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0e)); \
+    } while (0)
+
+static void __attribute__((target("sha,sse4.1"))) processblocks_sha_ni(SHA256_CTX *ctx, const UCHAR *buffer,
+                                                                        ULONG count)
+{
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i state0, state1, abef, cdgh, msg, tmp, m0, m1, m2, m3;
+
+    /* the SHA instructions work on ABEF and CDGH */
+    tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&ctx->h[0]), 0xb1);
+    state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&ctx->h[4]), 0x1b);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+    for (; count; count--, buffer += 64)
+    {
+        abef = state0;
+        cdgh = state1;
+
+        m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)buffer), mask);
+        m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buffer + 16)), mask);
+        m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buffer + 32)), mask);
+        m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buffer + 48)), mask);
+
+        SHA_NI_ROUNDS(0, m0, m1, m2, m3);
+        SHA_NI_ROUNDS(1, m1, m2, m3, m0);
+        SHA_NI_ROUNDS(2, m2, m3, m0, m1);
+        SHA_NI_ROUNDS(3, m3, m0, m1, m2);
+        SHA_NI_ROUNDS(4, m0, m1, m2, m3);
+        SHA_NI_ROUNDS(5, m1, m2, m3, m0);
+        SHA_NI_ROUNDS(6, m2, m3, m0, m1);
+        SHA_NI_ROUNDS(7, m3, m0, m1, m2);
+        SHA_NI_ROUNDS(8, m0, m1, m2, m3);
+        SHA_NI_ROUNDS(9, m1, m2, m3, m0);
+        SHA_NI_ROUNDS(10, m2, m3, m0, m1);
+        SHA_NI_ROUNDS(11, m3, m0, m1, m2);
+        SHA_NI_ROUNDS(12, m0, m1, m2, m3);
+        SHA_NI_ROUNDS(13, m1, m2, m3, m0);
+        SHA_NI_ROUNDS(14, m2, m3, m0, m1);
+        SHA_NI_ROUNDS(15, m3, m0, m1, m2);
+
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1b);
+    state1 = _mm_shuffle_epi32(state1, 0xb1);
+    _mm_storeu_si128((__m128i *)&ctx->h[0], _mm_blend_epi16(tmp, state1, 0xf0));
+    _mm_storeu_si128((__m128i *)&ctx->h[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+
+static BOOL have_sha_ni(void)
+{
+    int regs[4];
+
+    __cpuid(regs, 0);
+    if (regs[0] < 7) return FALSE;
+    __cpuid(regs, 1);
+    if (!(regs[2] & (1 << 19))) return FALSE; /* SSE4.1 */
+    __cpuidex(regs, 7, 0);
+    return !!(regs[1] & (1 << 29));
+}
+
+#endif
+
+static void (*processblocks)(SHA256_CTX *ctx, const UCHAR *buffer, ULONG count);
+
+static void init_processblocks(void)
+{
+#ifdef HAVE_SHA_NI
+    if (have_sha_ni())
+    {
+        processblocks = processblocks_sha_ni;
+        return;
+    }
+#endif
+    processblocks = processblocks_c;
+}
+
 static void pad(SHA256_CTX *ctx)
 {
     ULONG64 r = ctx->len % 64;
@@ -101,7 +203,7 @@ static void pad(SHA256_CTX *ctx)
     {
         memset(ctx->buf + r, 0, 64 - r);
         r = 0;
-        processblock(ctx, ctx->buf);
+        processblocks(ctx, ctx->buf, 1);
     }
 
     memset(ctx->buf + r, 0, 56 - r);
@@ -115,11 +217,13 @@ static void pad(SHA256_CTX *ctx)
     ctx->buf[62] = ctx->len >> 8;
     ctx->buf[63] = ctx->len;
 
-    processblock(ctx, ctx->buf);
+    processblocks(ctx, ctx->buf, 1);
 }
 
 void sha256_init(SHA256_CTX *ctx)
 {
+    if (!processblocks) init_processblocks();
+
     ctx->len = 0;
     ctx->h[0] = 0x6a09e667;
     ctx->h[1] = 0xbb67ae85;
@@ -147,11 +251,11 @@ void sha256_update(SHA256_CTX *ctx, const UCHAR *buffer, ULONG len)
         memcpy(ctx->buf + r, p, 64 - r);
         len -= 64 - r;
         p += 64 - r;
-        processblock(ctx, ctx->buf);
+        processblocks(ctx, ctx->buf, 1);
     }
-    for (; len >= 64; len -= 64, p += 64)
-        processblock(ctx, p);
-    memcpy(ctx->buf, p, len);
+    processblocks(ctx, p, len / 64);
+    p += len & ~63;
+    memcpy(ctx->buf, p, len % 64);
 }
 
 void sha256_finalize(SHA256_CTX *ctx, UCHAR *buffer)
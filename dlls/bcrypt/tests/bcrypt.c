@@ -414,6 +414,102 @@ static void test_hashes(void)
         test_hash(tests+i);
 }
 
+static void test_hash_large(void)
+{
+    static const struct
+    {
+        const WCHAR *alg;
+        ULONG hash_size;
+        const char *hash;
+    }
+    tests[] =
+    {
+        { L"SHA256", 32, "e3fb0d93b7aecc2b6a9e087ba99ce53ec1808f56ad084ad7ccf93a0e4850b682" },
+        { L"SHA512", 64, "f19bc36921ff43406f7949208874806c7aadbd2b60e83009f0d31aa220bf9818"
+                         "8450e1fdaf3aea3ff5e6a9988c76430e881bf790d72c0a9cc3a824ef94205162" },
+    };
+    static const ULONG chunks[] = { 1, 63, 64, 65, 127, 128, 129, 5000 };
+    BCRYPT_ALG_HANDLE alg;
+    BCRYPT_HASH_HANDLE hash;
+    UCHAR data[5000], hash_buf[64];
+    char str[129];
+    unsigned int i, j;
+    NTSTATUS ret;
+    ULONG pos;
+
+    for (i = 0; i < sizeof(data); i++) data[i] = i * 7 + (i >> 9);
+
+    for (i = 0; i < ARRAY_SIZE(tests); i++)
+    {
+        ret = BCryptOpenAlgorithmProvider(&alg, tests[i].alg, MS_PRIMITIVE_PROVIDER, 0);
+        ok(ret == STATUS_SUCCESS, "got %#lx\n", ret);
+
+        for (j = 0; j < ARRAY_SIZE(chunks); j++)
+        {
+            ret = BCryptCreateHash(alg, &hash, NULL, 0, NULL, 0, 0);
+            ok(ret == STATUS_SUCCESS, "got %#lx\n", ret);
+
+            for (pos = 0; pos < sizeof(data); pos += chunks[j])
+            {
+                ret = BCryptHashData(hash, data + pos, min(chunks[j], sizeof(data) - pos), 0);
+                ok(ret == STATUS_SUCCESS, "got %#lx\n", ret);
+            }
+
+            ret = BCryptFinishHash(hash, hash_buf, tests[i].hash_size, 0);
+            ok(ret == STATUS_SUCCESS, "got %#lx\n", ret);
+            format_hash(hash_buf, tests[i].hash_size, str);
+            ok(!strcmp(str, tests[i].hash), "%s chunk %lu: got %s\n", wine_dbgstr_w(tests[i].alg), chunks[j], str);
+
+            BCryptDestroyHash(hash);
+        }
+
+        BCryptCloseAlgorithmProvider(alg, 0);
+    }
+}
+
+static void test_hash_throughput(void)
+{
+    static const WCHAR *algs[] = { L"SHA256", L"SHA512" };
+    static const ULONG size = 16 * 1024 * 1024;
+    BCRYPT_ALG_HANDLE alg;
+    BCRYPT_HASH_HANDLE hash;
+    LARGE_INTEGER freq, start, end;
+    UCHAR *data, hash_buf[64];
+    ULONG hash_size, len;
+    unsigned int i;
+    NTSTATUS ret;
+    double secs;
+
+    if (!(data = malloc(size))) return;
+    memset(data, 0x5a, size);
+    QueryPerformanceFrequency(&freq);
+
+    for (i = 0; i < ARRAY_SIZE(algs); i++)
+    {
+        ret = BCryptOpenAlgorithmProvider(&alg, algs[i], MS_PRIMITIVE_PROVIDER, 0);
+        ok(ret == STATUS_SUCCESS, "got %#lx\n", ret);
+        ret = BCryptGetProperty(alg, BCRYPT_HASH_LENGTH, (UCHAR *)&hash_size, sizeof(hash_size), &len, 0);
+        ok(ret == STATUS_SUCCESS, "got %#lx\n", ret);
+
+        QueryPerformanceCounter(&start);
+        ret = BCryptCreateHash(alg, &hash, NULL, 0, NULL, 0, 0);
+        ok(ret == STATUS_SUCCESS, "got %#lx\n", ret);
+        ret = BCryptHashData(hash, data, size, 0);
+        ok(ret == STATUS_SUCCESS, "got %#lx\n", ret);
+        ret = BCryptFinishHash(hash, hash_buf, hash_size, 0);
+        ok(ret == STATUS_SUCCESS, "got %#lx\n", ret);
+        BCryptDestroyHash(hash);
+        QueryPerformanceCounter(&end);
+
+        secs = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+        trace("%s: hashed %lu MB in %.3f s, %.1f MB/s\n", wine_dbgstr_w(algs[i]), size >> 20, secs,
+              secs > 0 ? (size >> 20) / secs : 0.0);
+
+        BCryptCloseAlgorithmProvider(alg, 0);
+    }
+    free(data);
+}
+
 static void test_BcryptHash(void)
 {
     static const char expected[] =
@@ -3711,6 +3807,8 @@ START_TEST(bcrypt)
     test_BCryptGenRandom();
     test_BCryptGetFipsAlgorithmMode();
     test_hashes();
+    test_hash_large();
+    if (winetest_interactive) test_hash_throughput();
     test_BcryptHash();
     test_BcryptDeriveKeyPBKDF2();
     test_rng();
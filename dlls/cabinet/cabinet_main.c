@@ -22,6 +22,7 @@
 #include <stdarg.h>
 #include <string.h>
 #include <fcntl.h>
+#include <zlib.h>
 
 #include "windef.h"
 #include "winbase.h"
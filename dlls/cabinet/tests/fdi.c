@@ -114,6 +114,41 @@ static const struct
     { 'H','e','l','l','o',' ','W','o','r','l','d','!' }
 };
 
+/* two MSZIP blocks of "0123456789abcdef" repeated, the second one only
+ * refers back to data of the first block */
+static const struct
+{
+    struct CFHEADER header;
+    struct CFFOLDER folder;
+    struct CFFILE file;
+    UCHAR szName[sizeof("file.dat")];
+    struct CFDATA data1;
+    UCHAR ab1[99];
+    struct CFDATA data2;
+    UCHAR ab2[26];
+} zip_cab_data =
+{
+    { {'M','S','C','F'}, 0, 0xd2, 0, sizeof(struct CFHEADER) + sizeof(struct CFFOLDER), 0, 3,1, 1, 1, 0, 0x1225, 0x2013 },
+    { sizeof(struct CFHEADER) + sizeof(struct CFFOLDER) + sizeof(struct CFFILE) + sizeof("file.dat"), 2, tcompTYPE_MSZIP },
+    { 0x9000, 0, 0, 0x1225, 0x2013, 0xa114 },
+    { 'f','i','l','e','.','d','a','t',0 },
+    { 0, 99, 0x8000 },
+    {
+        0x43, 0x4b, 0xed, 0xc7, 0xc9, 0x01, 0xc0, 0x10, 0x00, 0x00, 0xb0, 0x95, 0x94, 0xba, 0xc6,
+        0x41, 0xd9, 0x7f, 0x84, 0x0e, 0x22, 0xf9, 0x25, 0x3c, 0x31, 0xbd, 0xb9, 0xd4, 0xd6, 0xc7,
+        0x5c, 0xdf, 0x3e, 0xc1, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd,
+        0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd,
+        0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd,
+        0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd,
+        0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xfd, 0xc2, 0xff
+    },
+    { 0, 26, 0x1000 },
+    {
+        0x43, 0x4b, 0xed, 0xc7, 0x31, 0x0d, 0x00, 0x00, 0x00, 0x80, 0xa0, 0xfe, 0xad, 0xed, 0xe1,
+        0xe0, 0xc3, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xff, 0x0f
+    }
+};
+
 #include <poppack.h>
 
 struct mem_data
@@ -854,6 +889,52 @@ static INT_PTR CDECL fdi_mem_notify(FDINOTIFICATIONTYPE fdint, FDINOTIFICATION *
     return 0;
 }
 
+static LONG zip_written;
+
+static INT_PTR CDECL fdi_zip_open(char *name, int oflag, int pmode)
+{
+    struct mem_data *data;
+
+    data = HeapAlloc(GetProcessHeap(), 0, sizeof(*data));
+    if (!data) return -1;
+
+    data->base = (const char *)&zip_cab_data;
+    data->size = sizeof(zip_cab_data);
+    data->pos = 0;
+    return (INT_PTR)data;
+}
+
+static UINT CDECL fdi_zip_write(INT_PTR hf, void *pv, UINT cb)
+{
+    static const char pattern[] = "0123456789abcdef";
+    const char *buf = pv;
+    UINT i;
+
+    ok(hf == 0x12345678, "expected 0x12345678, got %#Ix\n", hf);
+    for (i = 0; i < cb; i++)
+        if (buf[i] != pattern[(zip_written + i) % 16]) break;
+    ok(i == cb, "got wrong data at offset %lu\n", zip_written + i);
+
+    zip_written += cb;
+    return cb;
+}
+
+static INT_PTR CDECL fdi_zip_notify(FDINOTIFICATIONTYPE fdint, FDINOTIFICATION *info)
+{
+    switch (fdint)
+    {
+    case fdintCOPY_FILE:
+        ok(info->cb == 0x9000, "expected 0x9000, got %#lx\n", info->cb);
+        return 0x12345678;
+
+    case fdintCLOSE_FILE_INFO:
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
 static void test_FDICopy(void)
 {
     CCAB cabParams;
@@ -939,6 +1020,105 @@ static void test_FDICopy(void)
     ok(ret, "FDICopy error %d\n", erf.erfOper);
 
     FDIDestroy(hfdi);
+
+    /* MSZIP blocks of a folder share the same history */
+    hfdi = FDICreate(fdi_alloc, fdi_free, fdi_zip_open, fdi_mem_read,
+                     fdi_zip_write, fdi_mem_close, fdi_mem_seek, cpuUNKNOWN, &erf);
+    ok(hfdi != NULL, "FDICreate error %d\n", erf.erfOper);
+
+    zip_written = 0;
+    ret = FDICopy(hfdi, block, memory, 0, fdi_zip_notify, NULL, 0);
+    ok(ret, "FDICopy error %d\n", erf.erfOper);
+    ok(zip_written == 0x9000, "expected 0x9000 bytes, got %#lx\n", zip_written);
+
+    FDIDestroy(hfdi);
+}
+
+static LONG bench_written;
+
+static UINT CDECL fdi_bench_write(INT_PTR hf, void *pv, UINT cb)
+{
+    bench_written += cb;
+    return cb;
+}
+
+static INT_PTR CDECL fdi_bench_notify(FDINOTIFICATIONTYPE fdint, FDINOTIFICATION *info)
+{
+    switch (fdint)
+    {
+    case fdintCOPY_FILE:
+        return 0x12345678; /* output is discarded by fdi_bench_write() */
+
+    case fdintCLOSE_FILE_INFO:
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
+static void test_mszip_throughput(void)
+{
+    static const DWORD size = 16 * 1024 * 1024;
+    static char bench_dat[] = "bench.dat";
+    char name[] = "extract.cab";
+    char path[MAX_PATH + 1];
+    LARGE_INTEGER freq, start, end;
+    CCAB cabParams;
+    DWORD i, written, len;
+    HANDLE file;
+    HFDI hfdi;
+    HFCI hfci;
+    char *buf;
+    ERF erf;
+    BOOL ret;
+
+    len = GetCurrentDirectoryA(MAX_PATH, CURR_DIR);
+    if (len && CURR_DIR[len - 1] == '\\') CURR_DIR[len - 1] = 0;
+
+    /* text-like data, so that most blocks use dynamic Huffman codes */
+    buf = HeapAlloc(GetProcessHeap(), 0, size);
+    for (i = 0; i < size; i++)
+        buf[i] = 'a' + (i * 7 + (i >> 5) * 13 + (i >> 11)) % 26;
+
+    file = CreateFileA(bench_dat, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "failed to create %s\n", bench_dat);
+    WriteFile(file, buf, size, &written, NULL);
+    CloseHandle(file);
+    HeapFree(GetProcessHeap(), 0, buf);
+
+    set_cab_parameters(&cabParams);
+    hfci = FCICreate(&erf, file_placed, mem_alloc, mem_free, fci_open,
+                     fci_read, fci_write, fci_close, fci_seek,
+                     fci_delete, get_temp_file, &cabParams, NULL);
+    ok(hfci != NULL, "Failed to create an FCI context\n");
+    add_file(hfci, bench_dat);
+    ret = FCIFlushCabinet(hfci, FALSE, get_next_cabinet, progress);
+    ok(ret, "Failed to flush the cabinet\n");
+    FCIDestroy(hfci);
+
+    lstrcpyA(path, CURR_DIR);
+    lstrcatA(path, "\\");
+
+    hfdi = FDICreate(fdi_alloc, fdi_free, fdi_open, fdi_read,
+                     fdi_bench_write, fdi_close, fdi_seek, cpuUNKNOWN, &erf);
+    ok(hfdi != NULL, "FDICreate error %d\n", erf.erfOper);
+
+    bench_written = 0;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    ret = FDICopy(hfdi, name, path, 0, fdi_bench_notify, NULL, 0);
+    QueryPerformanceCounter(&end);
+    ok(ret, "FDICopy error %d\n", erf.erfOper);
+    ok(bench_written == size, "expected %lu bytes, got %ld\n", size, bench_written);
+
+    trace("MSZIP: extracted %ld bytes in %.3f s, %.1f MB/s\n", bench_written,
+          (double)(end.QuadPart - start.QuadPart) / freq.QuadPart,
+          (double)bench_written / (1024 * 1024) * freq.QuadPart / (end.QuadPart - start.QuadPart));
+
+    FDIDestroy(hfdi);
+    DeleteFileA(name);
+    DeleteFileA(bench_dat);
 }
 
 
@@ -948,4 +1128,7 @@ START_TEST(fdi)
     test_FDIDestroy();
     test_FDIIsCabinet();
     test_FDICopy();
+
+    if (winetest_interactive)
+        test_mszip_throughput();
 }
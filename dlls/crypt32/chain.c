@@ -28,12 +28,15 @@
 #include "wincrypt.h"
 #include "wininet.h"
 #include "wine/debug.h"
+#include "wine/list.h"
 #include "crypt32_private.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(crypt);
 WINE_DECLARE_DEBUG_CHANNEL(chain);
 
 #define DEFAULT_CYCLE_MODULUS 7
+#define MAX_CACHED_CHAINS 256
+#define CHAIN_CACHE_TIMEOUT 60000 /* ms */
 
 /* This represents a subset of a certificate chain engine:  it doesn't include
  * the "hOther" store described by MSDN, because I'm not sure how that's used.
@@ -49,8 +52,48 @@ typedef struct _CertificateChainEngine
     DWORD      dwUrlRetrievalTimeout;
     DWORD      MaximumCachedCertificates;
     DWORD      CycleDetectionModulus;
+    /* trust results of chains built for the current time, most recently
+     * used first */
+    CRITICAL_SECTION cs;
+    struct list chain_cache;
+    DWORD      cached_chains;
+    LONG       cache_hits;
+    LONG       cache_misses;
+    LONGLONG   build_time;
 } CertificateChainEngine;
 
+/* The cache doesn't hold any context, so that it neither keeps the stores of
+ * the calling application alive nor hands one caller's context to another.
+ * The issuers are found again by hash in the stores of the current call.
+ */
+struct chain_cache_element
+{
+    BYTE hash[20];
+    CERT_TRUST_STATUS TrustStatus;
+};
+
+struct chain_cache_entry
+{
+    struct list entry;
+    ULONGLONG expire_time;
+    FILETIME valid_until;
+    CERT_TRUST_STATUS TrustStatus;
+    CERT_TRUST_STATUS SimpleTrustStatus;
+    BOOL fHasRevocationFreshnessTime;
+    DWORD dwRevocationFreshnessTime;
+    BYTE *key;
+    DWORD key_size;
+    DWORD cElement;
+    struct chain_cache_element rgElement[1];
+};
+
+struct chain_cache_key
+{
+    BYTE *data;
+    DWORD size;
+    DWORD alloc;
+};
+
 static inline void CRYPT_AddStoresToCollection(HCERTSTORE collection,
  DWORD cStores, HCERTSTORE *stores)
 {
@@ -154,6 +197,14 @@ HCERTCHAINENGINE CRYPT_CreateChainEngine(HCERTSTORE root, DWORD system_store, co
     else
         engine->CycleDetectionModulus = DEFAULT_CYCLE_MODULUS;
 
+    InitializeCriticalSection(&engine->cs);
+    engine->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": CertificateChainEngine.cs");
+    list_init(&engine->chain_cache);
+    engine->cached_chains = 0;
+    engine->cache_hits = 0;
+    engine->cache_misses = 0;
+    engine->build_time = 0;
+
     return engine;
 }
 
@@ -194,11 +245,28 @@ static CertificateChainEngine *get_chain_engine(HCERTCHAINENGINE handle, BOOL al
     return (CertificateChainEngine*)handle;
 }
 
+static void free_chain_cache_entry(CertificateChainEngine *engine,
+ struct chain_cache_entry *entry)
+{
+    list_remove(&entry->entry);
+    engine->cached_chains--;
+    CryptMemFree(entry);
+}
+
 static void free_chain_engine(CertificateChainEngine *engine)
 {
+    struct chain_cache_entry *entry, *next;
+
     if(!engine || InterlockedDecrement(&engine->ref))
         return;
 
+    TRACE_(chain)("%p: %ld cache hits, %ld misses\n", engine, engine->cache_hits,
+     engine->cache_misses);
+    LIST_FOR_EACH_ENTRY_SAFE(entry, next, &engine->chain_cache, struct chain_cache_entry, entry)
+        free_chain_cache_entry(engine, entry);
+    engine->cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection(&engine->cs);
+
     CertCloseStore(engine->hWorld, 0);
     CertCloseStore(engine->hRoot, 0);
     CryptMemFree(engine);
@@ -2872,14 +2940,266 @@ static void dump_chain_para(const CERT_CHAIN_PARA *pChainPara)
     }
 }
 
+static BOOL append_chain_cache_key(struct chain_cache_key *key, const void *data,
+ DWORD size)
+{
+    if (key->size + size > key->alloc)
+    {
+        DWORD alloc = max(key->alloc * 2, key->size + size);
+        BYTE *ptr = CryptMemRealloc(key->data, alloc);
+
+        if (!ptr)
+            return FALSE;
+        key->data = ptr;
+        key->alloc = alloc;
+    }
+    memcpy(key->data + key->size, data, size);
+    key->size += size;
+    return TRUE;
+}
+
+static BOOL append_cert_hash_to_key(struct chain_cache_key *key,
+ PCCERT_CONTEXT cert)
+{
+    BYTE hash[20];
+    DWORD size = sizeof(hash);
+
+    return CertGetCertificateContextProperty(cert, CERT_HASH_PROP_ID, hash, &size) &&
+     append_chain_cache_key(key, hash, size);
+}
+
+static BOOL append_usage_to_key(struct chain_cache_key *key,
+ const CERT_USAGE_MATCH *usage)
+{
+    DWORD i;
+
+    if (!append_chain_cache_key(key, &usage->dwType, sizeof(usage->dwType)) ||
+     !append_chain_cache_key(key, &usage->Usage.cUsageIdentifier,
+     sizeof(usage->Usage.cUsageIdentifier)))
+        return FALSE;
+    for (i = 0; i < usage->Usage.cUsageIdentifier; i++)
+    {
+        const char *oid = usage->Usage.rgpszUsageIdentifier[i];
+
+        if (!append_chain_cache_key(key, oid, strlen(oid) + 1))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* Chains are cached by the hashes of the end certificate and of the
+ * certificates in the additional store, and by the parameters that affect
+ * the trust status.
+ */
+static BOOL get_chain_cache_key(PCCERT_CONTEXT cert, HCERTSTORE store,
+ const CERT_CHAIN_PARA *para, DWORD flags, struct chain_cache_key *key)
+{
+    PCCERT_CONTEXT store_cert = NULL;
+    BOOL ret;
+
+    key->data = NULL;
+    key->size = key->alloc = 0;
+    ret = append_chain_cache_key(key, &flags, sizeof(flags)) &&
+     append_cert_hash_to_key(key, cert);
+    while (ret && store && (store_cert = CertEnumCertificatesInStore(store, store_cert)))
+        ret = append_cert_hash_to_key(key, store_cert);
+    if (store_cert)
+        CertFreeCertificateContext(store_cert);
+    if (ret && para->cbSize >= sizeof(CERT_CHAIN_PARA_NO_EXTRA_FIELDS))
+        ret = append_usage_to_key(key, &para->RequestedUsage);
+    if (ret && para->cbSize >= sizeof(CERT_CHAIN_PARA))
+        ret = append_usage_to_key(key, &para->RequestedIssuancePolicy) &&
+         append_chain_cache_key(key, &para->fCheckRevocationFreshnessTime,
+         sizeof(para->fCheckRevocationFreshnessTime)) &&
+         append_chain_cache_key(key, &para->dwRevocationFreshnessTime,
+         sizeof(para->dwRevocationFreshnessTime));
+    if (!ret)
+        CryptMemFree(key->data);
+    return ret;
+}
+
+/* Returns a copy of the cached trust results for key, if any. */
+static struct chain_cache_entry *find_cached_chain(CertificateChainEngine *engine,
+ const struct chain_cache_key *key)
+{
+    struct chain_cache_entry *entry, *copy = NULL;
+    ULONGLONG tick = GetTickCount64();
+    FILETIME now;
+
+    GetSystemTimeAsFileTime(&now);
+    EnterCriticalSection(&engine->cs);
+    LIST_FOR_EACH_ENTRY(entry, &engine->chain_cache, struct chain_cache_entry, entry)
+    {
+        DWORD size = offsetof(struct chain_cache_entry, rgElement[entry->cElement]);
+
+        if (entry->key_size != key->size || memcmp(entry->key, key->data, key->size))
+            continue;
+        if (entry->expire_time <= tick || CompareFileTime(&now, &entry->valid_until) > 0)
+            free_chain_cache_entry(engine, entry);
+        else if ((copy = CryptMemAlloc(size)))
+        {
+            memcpy(copy, entry, size);
+            copy->key = NULL;
+            copy->key_size = 0;
+            list_remove(&entry->entry);
+            list_add_head(&engine->chain_cache, &entry->entry);
+        }
+        break;
+    }
+    LeaveCriticalSection(&engine->cs);
+    return copy;
+}
+
+/* Rebuilds a chain around cert from cached trust results. Fails if one of
+ * the issuers can't be found anymore, or if the root is no longer trusted.
+ */
+static CertificateChain *CRYPT_BuildChainFromCache(CertificateChainEngine *engine,
+ PCCERT_CONTEXT cert, HCERTSTORE hAdditionalStore,
+ const struct chain_cache_entry *entry)
+{
+    PCERT_SIMPLE_CHAIN simpleChain;
+    CertificateChain *chain = NULL;
+    HCERTSTORE world;
+    DWORD i;
+
+    if (!(simpleChain = CryptMemAlloc(sizeof(CERT_SIMPLE_CHAIN))))
+        return NULL;
+    memset(simpleChain, 0, sizeof(CERT_SIMPLE_CHAIN));
+    simpleChain->cbSize = sizeof(CERT_SIMPLE_CHAIN);
+    simpleChain->TrustStatus = entry->SimpleTrustStatus;
+    if (!(simpleChain->rgpElement = CryptMemAlloc(entry->cElement * sizeof(PCERT_CHAIN_ELEMENT))))
+    {
+        CryptMemFree(simpleChain);
+        return NULL;
+    }
+
+    world = CertOpenStore(CERT_STORE_PROV_COLLECTION, 0, 0,
+     CERT_STORE_CREATE_NEW_FLAG, NULL);
+    CertAddStoreToCollection(world, engine->hWorld, 0, 0);
+    if (hAdditionalStore)
+        CertAddStoreToCollection(world, hAdditionalStore, 0, 0);
+
+    for (i = 0; i < entry->cElement; i++)
+    {
+        CRYPT_HASH_BLOB hash = { sizeof(entry->rgElement[i].hash),
+         (BYTE *)entry->rgElement[i].hash };
+        PCERT_CHAIN_ELEMENT element;
+        PCCERT_CONTEXT context;
+
+        /* copies of the root in other stores of the world don't make it trusted */
+        if (i == entry->cElement - 1)
+        {
+            if (!(context = CertFindCertificateInStore(engine->hRoot, X509_ASN_ENCODING, 0,
+             CERT_FIND_SHA1_HASH, &hash, NULL)))
+                break;
+            CertFreeCertificateContext(context);
+        }
+        if (!i)
+            context = CertDuplicateCertificateContext(cert);
+        else if (!(context = CertFindCertificateInStore(world, X509_ASN_ENCODING, 0,
+         CERT_FIND_SHA1_HASH, &hash, NULL)))
+            break;
+        if (!(element = CryptMemAlloc(sizeof(CERT_CHAIN_ELEMENT))))
+        {
+            CertFreeCertificateContext(context);
+            break;
+        }
+        memset(element, 0, sizeof(CERT_CHAIN_ELEMENT));
+        element->cbSize = sizeof(CERT_CHAIN_ELEMENT);
+        element->pCertContext = context;
+        element->TrustStatus = entry->rgElement[i].TrustStatus;
+        simpleChain->rgpElement[simpleChain->cElement++] = element;
+    }
+
+    if (simpleChain->cElement == entry->cElement &&
+     (chain = CryptMemAlloc(sizeof(CertificateChain))))
+    {
+        if ((chain->context.rgpChain = CryptMemAlloc(sizeof(PCERT_SIMPLE_CHAIN))))
+        {
+            chain->ref = 1;
+            chain->world = world;
+            chain->context.cbSize = sizeof(CERT_CHAIN_CONTEXT);
+            chain->context.TrustStatus = entry->TrustStatus;
+            chain->context.cChain = 1;
+            chain->context.rgpChain[0] = simpleChain;
+            chain->context.cLowerQualityChainContext = 0;
+            chain->context.rgpLowerQualityChainContext = NULL;
+            chain->context.fHasRevocationFreshnessTime = entry->fHasRevocationFreshnessTime;
+            chain->context.dwRevocationFreshnessTime = entry->dwRevocationFreshnessTime;
+            return chain;
+        }
+        CryptMemFree(chain);
+    }
+    CRYPT_FreeSimpleChain(simpleChain);
+    CertCloseStore(world, 0);
+    return NULL;
+}
+
+static void cache_chain(CertificateChainEngine *engine,
+ struct chain_cache_key *key, PCCERT_CHAIN_CONTEXT chain)
+{
+    struct chain_cache_entry *entry, *old, *next;
+    const CERT_SIMPLE_CHAIN *simpleChain;
+    DWORD i, size;
+
+    /* only simple chains without alternatives are rebuilt from the cache */
+    if (chain->cChain != 1 || chain->cLowerQualityChainContext)
+        return;
+    simpleChain = chain->rgpChain[0];
+
+    size = offsetof(struct chain_cache_entry, rgElement[simpleChain->cElement]);
+    if (!(entry = CryptMemAlloc(size + key->size)))
+        return;
+    entry->expire_time = GetTickCount64() + CHAIN_CACHE_TIMEOUT;
+    entry->valid_until.dwLowDateTime = entry->valid_until.dwHighDateTime = ~0u;
+    entry->TrustStatus = chain->TrustStatus;
+    entry->SimpleTrustStatus = simpleChain->TrustStatus;
+    entry->fHasRevocationFreshnessTime = chain->fHasRevocationFreshnessTime;
+    entry->dwRevocationFreshnessTime = chain->dwRevocationFreshnessTime;
+    entry->cElement = simpleChain->cElement;
+    for (i = 0; i < simpleChain->cElement; i++)
+    {
+        PCCERT_CONTEXT cert = simpleChain->rgpElement[i]->pCertContext;
+        DWORD hash_size = sizeof(entry->rgElement[i].hash);
+
+        if (!CertGetCertificateContextProperty(cert, CERT_HASH_PROP_ID,
+         entry->rgElement[i].hash, &hash_size))
+        {
+            CryptMemFree(entry);
+            return;
+        }
+        entry->rgElement[i].TrustStatus = simpleChain->rgpElement[i]->TrustStatus;
+        if (CompareFileTime(&cert->pCertInfo->NotAfter, &entry->valid_until) < 0)
+            entry->valid_until = cert->pCertInfo->NotAfter;
+    }
+    entry->key = (BYTE *)entry + size;
+    entry->key_size = key->size;
+    memcpy(entry->key, key->data, key->size);
+
+    EnterCriticalSection(&engine->cs);
+    LIST_FOR_EACH_ENTRY_SAFE(old, next, &engine->chain_cache, struct chain_cache_entry, entry)
+    {
+        if (old->key_size == key->size && !memcmp(old->key, key->data, key->size))
+            free_chain_cache_entry(engine, old);
+    }
+    if (engine->cached_chains >= MAX_CACHED_CHAINS)
+        free_chain_cache_entry(engine, LIST_ENTRY(list_tail(&engine->chain_cache),
+         struct chain_cache_entry, entry));
+    list_add_head(&engine->chain_cache, &entry->entry);
+    engine->cached_chains++;
+    LeaveCriticalSection(&engine->cs);
+}
+
 BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
  PCCERT_CONTEXT pCertContext, LPFILETIME pTime, HCERTSTORE hAdditionalStore,
  PCERT_CHAIN_PARA pChainPara, DWORD dwFlags, LPVOID pvReserved,
  PCCERT_CHAIN_CONTEXT* ppChainContext)
 {
     CertificateChainEngine *engine;
-    BOOL ret;
+    BOOL ret, cacheable;
     CertificateChain *chain = NULL;
+    struct chain_cache_key key;
+    LARGE_INTEGER start, end;
 
     TRACE("(%p, %p, %s, %p, %p, %08lx, %p, %p)\n", hChainEngine, pCertContext,
      debugstr_filetime(pTime), hAdditionalStore, pChainPara, dwFlags,
@@ -2904,6 +3224,36 @@ BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
 
     if (TRACE_ON(chain))
         dump_chain_para(pChainPara);
+
+    /* only chains verified against the current time can be reused */
+    cacheable = !pTime && get_chain_cache_key(pCertContext, hAdditionalStore,
+     pChainPara, dwFlags, &key);
+    if (cacheable)
+    {
+        struct chain_cache_entry *entry = find_cached_chain(engine, &key);
+
+        if (entry)
+        {
+            chain = CRYPT_BuildChainFromCache(engine, pCertContext,
+             hAdditionalStore, entry);
+            CryptMemFree(entry);
+        }
+        if (chain)
+        {
+            InterlockedIncrement(&engine->cache_hits);
+            CryptMemFree(key.data);
+            TRACE_(chain)("using cached trust results, error status: %08lx\n",
+             chain->context.TrustStatus.dwErrorStatus);
+            if (ppChainContext)
+                *ppChainContext = &chain->context;
+            else
+                CertFreeCertificateChain(&chain->context);
+            return TRUE;
+        }
+        InterlockedIncrement(&engine->cache_misses);
+    }
+    QueryPerformanceCounter(&start);
+
     /* FIXME: what about HCCE_LOCAL_MACHINE? */
     ret = CRYPT_BuildCandidateChainFromCert(engine, pCertContext, pTime,
      hAdditionalStore, dwFlags, &chain);
@@ -2932,11 +3282,23 @@ BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
         CRYPT_CheckUsages(pChain, pChainPara);
         TRACE_(chain)("error status: %08lx\n",
          pChain->TrustStatus.dwErrorStatus);
+        if (cacheable)
+        {
+            QueryPerformanceCounter(&end);
+            InterlockedExchangeAdd64(&engine->build_time, end.QuadPart - start.QuadPart);
+            TRACE_(chain)("%ld cache hits, %ld misses, %s ticks spent building chains\n",
+             engine->cache_hits, engine->cache_misses, wine_dbgstr_longlong(engine->build_time));
+            /* don't keep failures around, they may be fixed by store changes */
+            if (pChain->TrustStatus.dwErrorStatus == CERT_TRUST_NO_ERROR)
+                cache_chain(engine, &key, pChain);
+        }
         if (ppChainContext)
             *ppChainContext = pChain;
         else
             CertFreeCertificateChain(pChain);
     }
+    if (cacheable)
+        CryptMemFree(key.data);
     TRACE("returning %d\n", ret);
     return ret;
 }
@@ -5379,10 +5379,105 @@ static void testVerifyCertChainPolicy(void)
     check_msroot_policy();
 }
 
+static void test_chain_cache(void)
+{
+    CERT_CHAIN_ENGINE_CONFIG config = { sizeof(config) };
+    CERT_CHAIN_PARA para = { sizeof(para) };
+    PCCERT_CONTEXT cert, cert1, cert2, element;
+    PCCERT_CHAIN_CONTEXT chain1, chain2;
+    CRYPT_KEY_PROV_INFO *info;
+    CRYPT_DATA_BLOB blob;
+    CERT_NAME_BLOB name;
+    HCERTCHAINENGINE engine;
+    HCERTSTORE root;
+    BYTE name_buf[64];
+    HCRYPTPROV csp;
+    DWORD size;
+    BOOL ret;
+
+    name.pbData = name_buf;
+    name.cbData = sizeof(name_buf);
+    ret = CertStrToNameW(X509_ASN_ENCODING, L"CN=Wine chain cache test", CERT_X500_NAME_STR, NULL,
+     name.pbData, &name.cbData, NULL);
+    ok(ret, "CertStrToNameW failed: %08lx\n", GetLastError());
+
+    /* the certificate is valid for now, so that its chain can be cached */
+    cert = CertCreateSelfSignCertificate(0, &name, 0, NULL, NULL, NULL, NULL, NULL);
+    if (!cert)
+    {
+        skip("Couldn't create a self-signed certificate: %08lx\n", GetLastError());
+        return;
+    }
+
+    root = CertOpenStore(CERT_STORE_PROV_MEMORY, 0, 0, CERT_STORE_CREATE_NEW_FLAG, NULL);
+    ret = CertAddCertificateContextToStore(root, cert, CERT_STORE_ADD_ALWAYS, NULL);
+    ok(ret, "CertAddCertificateContextToStore failed: %08lx\n", GetLastError());
+    config.hExclusiveRoot = root;
+    ret = CertCreateCertificateChainEngine(&config, &engine);
+    ok(ret, "CertCreateCertificateChainEngine failed: %08lx\n", GetLastError());
+
+    cert1 = CertCreateCertificateContext(X509_ASN_ENCODING, cert->pbCertEncoded, cert->cbCertEncoded);
+    cert2 = CertCreateCertificateContext(X509_ASN_ENCODING, cert->pbCertEncoded, cert->cbCertEncoded);
+    ok(cert1 != cert2, "Expected different contexts\n");
+    blob.pbData = (BYTE *)L"cert2";
+    blob.cbData = sizeof(L"cert2");
+    ret = CertSetCertificateContextProperty(cert2, CERT_FRIENDLY_NAME_PROP_ID, 0, &blob);
+    ok(ret, "CertSetCertificateContextProperty failed: %08lx\n", GetLastError());
+
+    ret = CertGetCertificateChain(engine, cert1, NULL, NULL, &para, 0, NULL, &chain1);
+    ok(ret, "CertGetCertificateChain failed: %08lx\n", GetLastError());
+    ok(!chain1->TrustStatus.dwErrorStatus, "Got error status %08lx\n", chain1->TrustStatus.dwErrorStatus);
+    ok(chain1->rgpChain[0]->rgpElement[0]->pCertContext == cert1, "Got unexpected context\n");
+
+    /* a chain built for the same certificate must still start with the
+     * caller's context */
+    ret = CertGetCertificateChain(engine, cert2, NULL, NULL, &para, 0, NULL, &chain2);
+    ok(ret, "CertGetCertificateChain failed: %08lx\n", GetLastError());
+    ok(!chain2->TrustStatus.dwErrorStatus, "Got error status %08lx\n", chain2->TrustStatus.dwErrorStatus);
+    ok(chain2->cChain == 1, "Got %lu chains\n", chain2->cChain);
+    ok(chain2->rgpChain[0]->cElement == chain1->rgpChain[0]->cElement, "Got %lu elements\n",
+     chain2->rgpChain[0]->cElement);
+    element = chain2->rgpChain[0]->rgpElement[0]->pCertContext;
+    ok(element == cert2, "Got unexpected context\n");
+    size = 0;
+    ret = CertGetCertificateContextProperty(element, CERT_FRIENDLY_NAME_PROP_ID, NULL, &size);
+    ok(ret && size == sizeof(L"cert2"), "Expected the friendly name of the second context\n");
+    CertFreeCertificateChain(chain2);
+
+    /* removing the root from the store invalidates the cached results */
+    element = CertFindCertificateInStore(root, X509_ASN_ENCODING, 0, CERT_FIND_EXISTING, cert, NULL);
+    ok(element != NULL, "CertFindCertificateInStore failed: %08lx\n", GetLastError());
+    ret = CertDeleteCertificateFromStore(element);
+    ok(ret, "CertDeleteCertificateFromStore failed: %08lx\n", GetLastError());
+    ret = CertGetCertificateChain(engine, cert2, NULL, NULL, &para, 0, NULL, &chain2);
+    ok(ret, "CertGetCertificateChain failed: %08lx\n", GetLastError());
+    ok(chain2->TrustStatus.dwErrorStatus & CERT_TRUST_IS_UNTRUSTED_ROOT, "Got error status %08lx\n",
+     chain2->TrustStatus.dwErrorStatus);
+
+    CertFreeCertificateChain(chain1);
+    CertFreeCertificateContext(cert1);
+    CertFreeCertificateChain(chain2);
+    CertFreeCertificateContext(cert2);
+    CertFreeCertificateChainEngine(engine);
+    CertCloseStore(root, 0);
+
+    size = 0;
+    if (CertGetCertificateContextProperty(cert, CERT_KEY_PROV_INFO_PROP_ID, NULL, &size) &&
+     (info = malloc(size)))
+    {
+        if (CertGetCertificateContextProperty(cert, CERT_KEY_PROV_INFO_PROP_ID, info, &size))
+            CryptAcquireContextW(&csp, info->pwszContainerName, info->pwszProvName, info->dwProvType,
+             CRYPT_DELETEKEYSET);
+        free(info);
+    }
+    CertFreeCertificateContext(cert);
+}
+
 START_TEST(chain)
 {
     testCreateCertChainEngine();
     testVerifyCertChainPolicy();
     testGetCertChain();
     test_CERT_CHAIN_PARA_cbSize();
+    test_chain_cache();
 }
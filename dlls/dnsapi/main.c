@@ -85,13 +85,47 @@ DNS_STATUS WINAPI DnsAcquireContextHandle_W( DWORD flags, void *cred, HANDLE *co
     return ERROR_SUCCESS;
 }
 
+/* name lookups are cached by ws2_32, flush them if it is loaded */
+static void flush_addrinfo_cache( const char *name )
+{
+    void (WINAPI *pflush)( const char * );
+    HMODULE module;
+
+    if (!(module = GetModuleHandleW( L"ws2_32.dll" ))) return;
+    if ((pflush = (void *)GetProcAddress( module, "__wine_flush_addrinfo_cache" ))) pflush( name );
+}
+
+/* convert the name the same way as GetAddrInfoW, which encodes IDNs to punycode */
+static void flush_addrinfo_cache_w( const WCHAR *name )
+{
+    WCHAR *nameW = NULL;
+    char *nameA;
+    int i, len;
+
+    for (i = 0; name[i]; i++) if (name[i] > 'z') break;
+    if (name[i])
+    {
+        if (!(len = IdnToAscii( 0, name, -1, NULL, 0 ))) return;
+        if (!(nameW = malloc( len * sizeof(WCHAR) ))) return;
+        IdnToAscii( 0, name, -1, nameW, len );
+        name = nameW;
+    }
+    if ((nameA = strdup_wa( name )))
+    {
+        flush_addrinfo_cache( nameA );
+        free( nameA );
+    }
+    free( nameW );
+}
+
 /******************************************************************************
  * DnsFlushResolverCache               [DNSAPI.@]
  *
  */
 VOID WINAPI DnsFlushResolverCache(void)
 {
-    FIXME(": stub\n");
+    TRACE( "\n" );
+    flush_addrinfo_cache( NULL );
 }
 
 /******************************************************************************
@@ -100,8 +134,17 @@ VOID WINAPI DnsFlushResolverCache(void)
  */
 BOOL WINAPI DnsFlushResolverCacheEntry_A( PCSTR entry )
 {
-    FIXME( "%s: stub\n", debugstr_a(entry) );
+    WCHAR *entryW;
+
+    TRACE( "%s\n", debugstr_a(entry) );
     if (!entry) return FALSE;
+    /* getaddrinfo caches the name as passed */
+    flush_addrinfo_cache( entry );
+    if ((entryW = strdup_aw( entry )))
+    {
+        flush_addrinfo_cache_w( entryW );
+        free( entryW );
+    }
     return TRUE;
 }
 
@@ -111,8 +154,15 @@ BOOL WINAPI DnsFlushResolverCacheEntry_A( PCSTR entry )
  */
 BOOL WINAPI DnsFlushResolverCacheEntry_UTF8( PCSTR entry )
 {
-    FIXME( "%s: stub\n", debugstr_a(entry) );
+    WCHAR *entryW;
+
+    TRACE( "%s\n", debugstr_a(entry) );
     if (!entry) return FALSE;
+    if ((entryW = strdup_uw( entry )))
+    {
+        flush_addrinfo_cache_w( entryW );
+        free( entryW );
+    }
     return TRUE;
 }
 
@@ -122,8 +172,9 @@ BOOL WINAPI DnsFlushResolverCacheEntry_UTF8( PCSTR entry )
  */
 BOOL WINAPI DnsFlushResolverCacheEntry_W( PCWSTR entry )
 {
-    FIXME( "%s: stub\n", debugstr_w(entry) );
+    TRACE( "%s\n", debugstr_w(entry) );
     if (!entry) return FALSE;
+    flush_addrinfo_cache_w( entry );
     return TRUE;
 }
 
@@ -131,10 +182,39 @@ BOOL WINAPI DnsFlushResolverCacheEntry_W( PCWSTR entry )
  * DnsGetCacheDataTable                    [DNSAPI.@]
  *
  */
+static void CALLBACK add_cache_table_entry( const char *name, WORD type, void *context )
+{
+    DNS_CACHE_ENTRY **table = context, *entry;
+    WCHAR *nameW;
+    DWORD len;
+
+    len = MultiByteToWideChar( CP_ACP, 0, name, -1, NULL, 0 );
+    if (!(entry = calloc( 1, sizeof(*entry) + len * sizeof(WCHAR) ))) return;
+    nameW = (WCHAR *)(entry + 1);
+    MultiByteToWideChar( CP_ACP, 0, name, -1, nameW, len );
+    entry->Name = nameW;
+    entry->Type = type;
+    entry->Next = *table;
+    *table = entry;
+}
+
 BOOL WINAPI DnsGetCacheDataTable( PDNS_CACHE_ENTRY* entry )
 {
-    FIXME( "(%p) stub\n", entry );
-    return FALSE;
+    void (WINAPI *penum)( void (CALLBACK *)( const char *, WORD, void * ), void * );
+    DNS_CACHE_ENTRY *table = NULL;
+    HMODULE module;
+
+    TRACE( "(%p)\n", entry );
+
+    if (!entry) return FALSE;
+
+    /* name lookups are cached by ws2_32, there is nothing to list if it isn't loaded */
+    if ((module = GetModuleHandleW( L"ws2_32.dll" )) &&
+        (penum = (void *)GetProcAddress( module, "__wine_enum_addrinfo_cache" )))
+        penum( add_cache_table_entry, &table );
+
+    *entry = table;
+    return table != NULL;
 }
 
 /******************************************************************************
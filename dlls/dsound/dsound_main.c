@@ -783,6 +783,7 @@ BOOL WINAPI DllMain(HINSTANCE hInstDLL, DWORD fdwReason, LPVOID lpvReserved)
         if (lpvReserved) break;
         DeleteCriticalSection(&DSOUND_renderers_lock);
         DeleteCriticalSection(&DSOUND_capturers_lock);
+        DSOUND_FreeFirTables();
         break;
     }
     return TRUE;
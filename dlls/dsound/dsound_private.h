@@ -231,6 +231,7 @@ HRESULT DSOUND_FullDuplexCreate(REFIID riid, void **ppv);
 void DSOUND_CheckEvent(const IDirectSoundBufferImpl *dsb, DWORD playpos, int len);
 void DSOUND_RecalcVolPan(PDSVOLUMEPAN volpan);
 void DSOUND_AmpFactorToVolPan(PDSVOLUMEPAN volpan);
+void DSOUND_FreeFirTables(void);
 void DSOUND_RecalcFormat(IDirectSoundBufferImpl *dsb);
 DWORD DSOUND_secpos_to_bufpos(const IDirectSoundBufferImpl *dsb, DWORD secpos, DWORD secmixpos, float *overshot);
 
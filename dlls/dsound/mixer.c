@@ -25,6 +25,11 @@
 #include <assert.h>
 #include <stdarg.h>
 #include <math.h>	/* Insomnia - pow() function */
+#ifdef __SSE__
+#include <xmmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 #define COBJMACROS
 
@@ -314,6 +319,79 @@ static UINT cp_fields_noresample(IDirectSoundBufferImpl *dsb, UINT count)
     return count;
 }
 
+/* Polyphase FIR tables, indexed by firstep. Row p of a table holds the FIR
+ * points p, p + firstep, p + 2 * firstep, ..., so the coefficients used for
+ * one output sample are contiguous. There are firstep + 1 rows so that the
+ * row following any phase can be used for linear interpolation. */
+static float * volatile fir_tables[128];
+
+static UINT fir_taps(UINT firstep)
+{
+    return (fir_len + firstep - 2) / firstep;
+}
+
+static const float *get_fir_table(UINT firstep)
+{
+    UINT taps = fir_taps(firstep), p, j;
+    float *table;
+
+    if (firstep >= ARRAY_SIZE(fir_tables)) return NULL;
+    if ((table = fir_tables[firstep])) return table;
+
+    if (!(table = malloc((firstep + 1) * taps * sizeof(float)))) return NULL;
+    for (p = 0; p <= firstep; p++)
+        for (j = 0; j < taps; j++)
+            table[p * taps + j] = p + j * firstep < fir_len ? fir[p + j * firstep] : 0.0f;
+
+    if (InterlockedCompareExchangePointer((void **)&fir_tables[firstep], table, NULL))
+    {
+        free(table);
+        table = fir_tables[firstep];
+    }
+    return table;
+}
+
+void DSOUND_FreeFirTables(void)
+{
+    UINT i;
+
+    for (i = 0; i < ARRAY_SIZE(fir_tables); i++)
+    {
+        free(fir_tables[i]);
+        fir_tables[i] = NULL;
+    }
+}
+
+static float dot_product(const float *a, const float *b, UINT len)
+{
+    float sum = 0.0f;
+    UINT i = 0;
+#ifdef __SSE__
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    float tmp[4];
+
+    for (; i + 8 <= len; i += 8)
+    {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    _mm_storeu_ps(tmp, _mm_add_ps(acc0, acc1));
+    sum = (tmp[0] + tmp[1]) + (tmp[2] + tmp[3]);
+#elif defined(__aarch64__)
+    float32x4_t acc0 = vdupq_n_f32(0.0f), acc1 = vdupq_n_f32(0.0f);
+
+    for (; i + 8 <= len; i += 8)
+    {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+#endif
+    for (; i < len; i++)
+        sum += a[i] * b[i];
+    return sum;
+}
+
 static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *freqAccNum)
 {
     UINT i, channel;
@@ -327,8 +405,9 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
     UINT channels = dsb->mix_channels;
     UINT max_ipos = (freqAcc_start + count * dsb->freqAdjustNum) / dsb->freqAdjustDen;
 
-    UINT fir_cachesize = (fir_len + dsbfirstep - 2) / dsbfirstep;
+    UINT fir_cachesize = fir_taps(dsbfirstep);
     UINT required_input = max_ipos + fir_cachesize;
+    const float *fir_table, *coeffs;
     float *intermediate, *fir_copy, *itmp;
 
     DWORD len = required_input * channels;
@@ -340,6 +419,12 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
     if (!secondarybuffer_is_audible(dsb))
         return max_ipos;
 
+    if (!(fir_table = get_fir_table(dsbfirstep)))
+    {
+        ERR("No FIR table for step %u\n", dsbfirstep);
+        return max_ipos;
+    }
+
     if (!dsb->device->cp_buffer) {
         dsb->device->cp_buffer = malloc(len);
         dsb->device->cp_buffer_len = len;
@@ -371,28 +456,33 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
     }
 
     for(i = 0; i < count; ++i) {
-        UINT int_fir_steps = (freqAcc_start + i * dsb->freqAdjustNum) * dsbfirstep / dsb->freqAdjustDen;
-        float total_fir_steps = (freqAcc_start + i * dsb->freqAdjustNum) * dsbfirstep / (float)dsb->freqAdjustDen;
+        LONG64 total_fir_steps = (freqAcc_start + i * dsb->freqAdjustNum) * dsbfirstep;
+        UINT int_fir_steps = total_fir_steps / dsb->freqAdjustDen;
+        LONG64 frac = total_fir_steps % dsb->freqAdjustDen;
         UINT ipos = int_fir_steps / dsbfirstep;
 
         UINT idx = (ipos + 1) * dsbfirstep - int_fir_steps - 1;
-        float rem = int_fir_steps + 1.0 - total_fir_steps;
-
-        int fir_used = 0;
-        while (idx < fir_len - 1) {
-            fir_copy[fir_used++] = fir[idx] * (1.0 - rem) + fir[idx + 1] * rem;
-            idx += dsb->firstep;
-        }
+        UINT fir_used = (fir_len - 2 - idx) / dsbfirstep + 1;
+        const float *row = fir_table + idx * fir_cachesize;
 
         assert(fir_used <= fir_cachesize);
         assert(ipos + fir_used <= required_input);
 
+        if (!frac) {
+            /* the output sample falls on a FIR point, e.g. with integer ratios */
+            coeffs = row + fir_cachesize;
+        } else {
+            float rem = 1.0f - (float)frac / dsb->freqAdjustDen;
+            UINT j;
+
+            for (j = 0; j < fir_used; j++)
+                fir_copy[j] = row[j] * (1.0f - rem) + row[j + fir_cachesize] * rem;
+            coeffs = fir_copy;
+        }
+
         for (channel = 0; channel < dsb->mix_channels; channel++) {
-            int j;
-            float sum = 0.0;
             float* cache = &intermediate[channel * required_input + ipos];
-            for (j = 0; j < fir_used; j++)
-                sum += fir_copy[j] * cache[j];
+            float sum = dot_product(coeffs, cache, fir_used);
             dsb->put(dsb, i * ostride, channel, sum * dsb->firgain);
         }
     }
@@ -1882,6 +1882,104 @@ static void test_AcquireResources(void)
     IDirectSound_Release(dsound);
 }
 
+static ULONGLONG get_cpu_time(void)
+{
+    FILETIME create, exit, kernel, user;
+
+    GetProcessTimes(GetCurrentProcess(), &create, &exit, &kernel, &user);
+    return (((ULONGLONG)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime)
+            + (((ULONGLONG)user.dwHighDateTime << 32) | user.dwLowDateTime);
+}
+
+/* Mixes buffers at rates that need both the exact and the interpolated
+ * polyphase FIR paths, and checks that they all consume their input at
+ * their own rate. */
+static void test_resample(unsigned int count)
+{
+    static const DWORD rates[] = {8000, 11025, 16000, 22050, 24000, 32000, 44100, 96000};
+    DSBUFFERDESC buffer_desc = {.dwSize = sizeof(buffer_desc)};
+    DWORD size, size1, size2, play, write, start, elapsed;
+    IDirectSoundBuffer **buffers;
+    ULONGLONG cpu_time;
+    DWORD *played, total = 0;
+    IDirectSound8 *dsound;
+    void *ptr1, *ptr2;
+    WAVEFORMATEX wfx;
+    unsigned int i;
+    char *data;
+    HRESULT hr;
+
+    hr = DirectSoundCreate8(NULL, &dsound, NULL);
+    ok(hr == DS_OK || hr == DSERR_NODRIVER, "Got hr %#lx.\n", hr);
+    if (FAILED(hr))
+        return;
+
+    hr = IDirectSound8_SetCooperativeLevel(dsound, get_hwnd(), DSSCL_PRIORITY);
+    ok(hr == DS_OK, "Got hr %#lx.\n", hr);
+
+    buffers = calloc(count, sizeof(*buffers));
+    played = calloc(count, sizeof(*played));
+
+    for (i = 0; i < count; i++)
+    {
+        init_format(&wfx, WAVE_FORMAT_PCM, rates[i % ARRAY_SIZE(rates)], 16, 2);
+        data = wave_generate_la(&wfx, 1.0, &size, FALSE);
+
+        buffer_desc.dwFlags = DSBCAPS_GETCURRENTPOSITION2 | DSBCAPS_LOCSOFTWARE;
+        buffer_desc.dwBufferBytes = size;
+        buffer_desc.lpwfxFormat = &wfx;
+        hr = IDirectSound8_CreateSoundBuffer(dsound, &buffer_desc, &buffers[i], NULL);
+        ok(hr == DS_OK, "Got hr %#lx.\n", hr);
+
+        hr = IDirectSoundBuffer_Lock(buffers[i], 0, 0, &ptr1, &size1, &ptr2, &size2, DSBLOCK_ENTIREBUFFER);
+        ok(hr == DS_OK, "Got hr %#lx.\n", hr);
+        memcpy(ptr1, data, size1);
+        hr = IDirectSoundBuffer_Unlock(buffers[i], ptr1, size1, ptr2, size2);
+        ok(hr == DS_OK, "Got hr %#lx.\n", hr);
+        HeapFree(GetProcessHeap(), 0, data);
+    }
+
+    cpu_time = get_cpu_time();
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+    {
+        hr = IDirectSoundBuffer_Play(buffers[i], 0, 0, 0);
+        ok(hr == DS_OK, "Got hr %#lx.\n", hr);
+    }
+
+    Sleep(500);
+
+    for (i = 0; i < count; i++)
+    {
+        hr = IDirectSoundBuffer_GetCurrentPosition(buffers[i], &play, &write);
+        ok(hr == DS_OK, "Got hr %#lx.\n", hr);
+        /* in milliseconds, 16-bit stereo */
+        played[i] = MulDiv(play, 1000, rates[i % ARRAY_SIZE(rates)] * 4);
+        total += played[i];
+    }
+    elapsed = GetTickCount() - start;
+    cpu_time = get_cpu_time() - cpu_time;
+
+    for (i = 0; i < count; i++)
+    {
+        ok(played[i] > 0, "Buffer at %lu Hz didn't play.\n", rates[i % ARRAY_SIZE(rates)]);
+        ok(abs((int)(played[i] - total / count)) < 100, "Buffer at %lu Hz played %lu ms, expected about %lu ms.\n",
+                rates[i % ARRAY_SIZE(rates)], played[i], total / count);
+    }
+
+    if (winetest_interactive)
+        trace("Mixed %u buffers for %lu ms using %I64u ms of CPU time.\n", count, elapsed, cpu_time / 10000);
+
+    for (i = 0; i < count; i++)
+    {
+        IDirectSoundBuffer_Stop(buffers[i]);
+        IDirectSoundBuffer_Release(buffers[i]);
+    }
+    free(played);
+    free(buffers);
+    IDirectSound8_Release(dsound);
+}
+
 START_TEST(dsound8)
 {
     DWORD cookie;
@@ -1896,6 +1994,13 @@ START_TEST(dsound8)
     test_first_device();
     test_primary_flags();
     test_AcquireResources();
+    test_resample(8);
+    if (winetest_interactive)
+    {
+        /* compare the mixer's CPU time with various numbers of resampled buffers */
+        test_resample(32);
+        test_resample(128);
+    }
 
     hr = CoRegisterClassObject(&testdmo_clsid, (IUnknown *)&testdmo_cf,
             CLSCTX_INPROC_SERVER, REGCLS_MULTIPLEUSE, &cookie);
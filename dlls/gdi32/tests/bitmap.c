@@ -3969,6 +3969,123 @@ static void test_GdiGradientFill(void)
     HeapFree(GetProcessHeap(), 0, bmi);
 }
 
+enum large_blit_op { LARGE_STRETCH, LARGE_SHRINK, LARGE_BLEND, LARGE_GRADIENT_H, LARGE_GRADIENT_TRIANGLE };
+
+static BOOL do_large_blit( HDC hdc, HDC hdc_src, enum large_blit_op op )
+{
+    static const BLENDFUNCTION blend = { AC_SRC_OVER, 0, 0xc0, AC_SRC_ALPHA };
+    TRIVERTEX vt[3] = { {   10,   20, 0xff00, 0x8000, 0x0000, 0xff00 },
+                        { 1000,  900, 0x0000, 0x4000, 0xff00, 0x4000 },
+                        {   40, 1010, 0x8000, 0xff00, 0x2000, 0x0000 } };
+    GRADIENT_TRIANGLE tri = { 0, 1, 2 };
+    GRADIENT_RECT rect = { 0, 1 };
+
+    switch (op)
+    {
+    case LARGE_STRETCH:
+        return StretchBlt( hdc, 1020, 3, -1013, 1017, hdc_src, 0, 0, 509, 511, SRCCOPY );
+    case LARGE_SHRINK:
+        return StretchBlt( hdc, 2, 1000, 1000, -600, hdc_src, 0, 0, 1024, 1021, SRCCOPY );
+    case LARGE_BLEND:
+        return pGdiAlphaBlend( hdc, 7, 5, 1000, 1010, hdc_src, 3, 1, 1000, 1010, blend );
+    case LARGE_GRADIENT_H:
+        return pGdiGradientFill( hdc, vt, 2, &rect, 1, GRADIENT_FILL_RECT_H );
+    case LARGE_GRADIENT_TRIANGLE:
+        return pGdiGradientFill( hdc, vt, 3, &tri, 1, GRADIENT_FILL_TRIANGLE );
+    }
+    return FALSE;
+}
+
+/* Large operations may be rendered in stripes by several threads, make sure
+ * the result is identical to the same operation clipped to small bands. */
+static void test_large_blits(void)
+{
+    static const WORD bpps[] = { 32, 24, 16, 8 };
+    BITMAPINFO *bmi;
+    HBITMAP bmp, bmp_band, bmp_src;
+    HDC hdc, hdc_band, hdc_src;
+    DWORD *src_bits, start, time_full, time_band;
+    BYTE *bits, *bits_band;
+    unsigned int i, j, op, size;
+    BOOL ret;
+
+    if (!pGdiAlphaBlend || !pGdiGradientFill)
+    {
+        win_skip( "GdiAlphaBlend or GdiGradientFill is not implemented\n" );
+        return;
+    }
+
+    bmi = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, FIELD_OFFSET( BITMAPINFO, bmiColors[256] ));
+    bmi->bmiHeader.biSize = sizeof(bmi->bmiHeader);
+    bmi->bmiHeader.biWidth = 1024;
+    bmi->bmiHeader.biHeight = -1024;
+    bmi->bmiHeader.biPlanes = 1;
+    bmi->bmiHeader.biBitCount = 32;
+    bmi->bmiHeader.biCompression = BI_RGB;
+    for (i = 0; i < 256; i++)
+    {
+        bmi->bmiColors[i].rgbRed   = i;
+        bmi->bmiColors[i].rgbGreen = i * 3;
+        bmi->bmiColors[i].rgbBlue  = i * 7;
+    }
+
+    hdc_src = CreateCompatibleDC( NULL );
+    bmp_src = CreateDIBSection( hdc_src, bmi, DIB_RGB_COLORS, (void **)&src_bits, NULL, 0 );
+    ok( bmp_src != NULL, "couldn't create bitmap\n" );
+    SelectObject( hdc_src, bmp_src );
+    for (i = 0; i < 1024 * 1024; i++) src_bits[i] = i * 2654435761u;
+
+    hdc = CreateCompatibleDC( NULL );
+    hdc_band = CreateCompatibleDC( NULL );
+
+    for (i = 0; i < ARRAY_SIZE(bpps); i++)
+    {
+        bmi->bmiHeader.biBitCount = bpps[i];
+        bmp = CreateDIBSection( hdc, bmi, DIB_RGB_COLORS, (void **)&bits, NULL, 0 );
+        ok( bmp != NULL, "couldn't create bitmap\n" );
+        SelectObject( hdc, bmp );
+        bmp_band = CreateDIBSection( hdc_band, bmi, DIB_RGB_COLORS, (void **)&bits_band, NULL, 0 );
+        ok( bmp_band != NULL, "couldn't create bitmap\n" );
+        SelectObject( hdc_band, bmp_band );
+        size = get_dib_image_size( bmi );
+
+        for (op = LARGE_STRETCH; op <= LARGE_GRADIENT_TRIANGLE; op++)
+        {
+            if (op == LARGE_BLEND && bpps[i] != 32) continue;
+
+            for (j = 0; j < size; j++) bits[j] = bits_band[j] = j * 3 + j / 4096;
+
+            start = GetTickCount();
+            ret = do_large_blit( hdc, hdc_src, op );
+            time_full = GetTickCount() - start;
+            ok( ret, "%u bpp op %u: failed\n", bpps[i], op );
+
+            start = GetTickCount();
+            for (j = 0; j < 1024; j += 8)
+            {
+                IntersectClipRect( hdc_band, 0, j, 1024, j + 8 );
+                ret = do_large_blit( hdc_band, hdc_src, op );
+                ok( ret, "%u bpp op %u: band %u failed\n", bpps[i], op, j );
+                SelectClipRgn( hdc_band, NULL );
+            }
+            time_band = GetTickCount() - start;
+
+            ok( !memcmp( bits, bits_band, size ), "%u bpp op %u: results differ\n", bpps[i], op );
+            if (winetest_debug > 1)
+                trace( "%u bpp op %u: full %lu ms, banded %lu ms\n", bpps[i], op, time_full, time_band );
+        }
+
+        DeleteObject( bmp );
+        DeleteObject( bmp_band );
+    }
+
+    DeleteDC( hdc );
+    DeleteDC( hdc_band );
+    DeleteDC( hdc_src );
+    DeleteObject( bmp_src );
+    HeapFree( GetProcessHeap(), 0, bmi );
+}
+
 static void test_clipping(void)
 {
     HBITMAP bmpDst;
@@ -6012,6 +6129,7 @@ START_TEST(bitmap)
     test_StretchDIBits();
     test_GdiAlphaBlend();
     test_GdiGradientFill();
+    test_large_blits();
     test_32bit_ddb();
     test_bitmapinfoheadersize();
     test_get16dibits();
@@ -51,6 +51,15 @@ typedef struct {
     int ref;
 } function_local_t;
 
+/* Compile time view of a function enclosing the code being compiled. */
+typedef struct _func_scope_t {
+    const function_code_t *func;
+    const WCHAR *self_name;     /* name bound by a named function expression */
+    BOOL dynamic_scope;         /* eval, with or catch may bind names at run time */
+    unsigned int scope_index;   /* scope of the outer function where the function is created */
+    struct _func_scope_t *outer;
+} func_scope_t;
+
 typedef struct _compiler_ctx_t {
     parser_ctx_t *parser;
     bytecode_t *code;
@@ -76,9 +85,15 @@ typedef struct _compiler_ctx_t {
 
     statement_ctx_t *stat_ctx;
     function_code_t *func;
+    func_scope_t *func_scope;
+    BOOL has_eval;
 
     unsigned loc;
 
+    unsigned local_ident_cnt;
+    unsigned outer_ident_cnt;
+    unsigned named_ident_cnt;
+
     function_expression_t *func_head;
     function_expression_t *func_tail;
     function_expression_t *current_function_expr;
@@ -307,6 +322,19 @@ static HRESULT push_instr_int(compiler_ctx_t *ctx, jsop_t op, LONG arg)
     return S_OK;
 }
 
+static HRESULT push_instr_int_uint(compiler_ctx_t *ctx, jsop_t op, LONG arg1, unsigned arg2)
+{
+    unsigned instr;
+
+    instr = push_instr(ctx, op);
+    if(!instr)
+        return E_OUTOFMEMORY;
+
+    instr_ptr(ctx, instr)->u.arg[0].lng = arg1;
+    instr_ptr(ctx, instr)->u.arg[1].uint = arg2;
+    return S_OK;
+}
+
 static HRESULT push_instr_str(compiler_ctx_t *ctx, jsop_t op, jsstr_t *str)
 {
     unsigned instr;
@@ -449,7 +477,7 @@ static HRESULT compile_member_expression(compiler_ctx_t *ctx, member_expression_
     if(FAILED(hres))
         return hres;
 
-    return push_instr_bstr(ctx, OP_member, expr->identifier);
+    return push_instr_bstr_uint(ctx, OP_member, expr->identifier, ++ctx->code->member_cache_cnt);
 }
 
 #define LABEL_FLAG 0x80000000
@@ -513,19 +541,95 @@ static BOOL bind_local(compiler_ctx_t *ctx, const WCHAR *identifier, int *ret_re
     return TRUE;
 }
 
+static BOOL is_block_scoped_in_function(const function_code_t *func, const WCHAR *identifier)
+{
+    unsigned int scope;
+
+    for(scope = 1; scope < func->local_scope_count; scope++) {
+        if(lookup_local(func, identifier, scope))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/*
+ * Binds an identifier not found by bind_local() to a function level variable
+ * of an enclosing function. This is only possible if nothing between the
+ * two functions may bind the same name at run time.
+ */
+static BOOL bind_outer_local(compiler_ctx_t *ctx, const WCHAR *identifier, int *ret_ref, unsigned *ret_depth)
+{
+    const func_scope_t *func_scope = ctx->func_scope;
+    const local_ref_t *ref;
+    statement_ctx_t *iter;
+    unsigned int creation_scope, depth = 0;
+
+    if(!func_scope || !wcscmp(identifier, L"arguments"))
+        return FALSE;
+
+    for(iter = ctx->stat_ctx; iter; iter = iter->next) {
+        if(iter->using_scope && !iter->block_scope)
+            return FALSE;
+    }
+
+    /* a block scoped variable which is not visible here, leave it to the run time lookup */
+    if(is_block_scoped_in_function(func_scope->func, identifier))
+        return FALSE;
+
+    for(;;) {
+        if(func_scope->dynamic_scope || (func_scope->self_name && !wcscmp(func_scope->self_name, identifier)))
+            return FALSE;
+        creation_scope = func_scope->scope_index;
+
+        /* variables of the global code don't live in a call frame */
+        func_scope = func_scope->outer;
+        if(!func_scope || !func_scope->outer)
+            return FALSE;
+        depth++;
+
+        /* block scopes enclosing the creation site may shadow function level variables */
+        if(creation_scope && is_block_scoped_in_function(func_scope->func, identifier))
+            return FALSE;
+
+        if((ref = lookup_local(func_scope->func, identifier, 0))) {
+            *ret_ref = ref->ref;
+            *ret_depth = depth;
+            return TRUE;
+        }
+    }
+}
+
 static HRESULT emit_identifier_ref(compiler_ctx_t *ctx, const WCHAR *identifier, unsigned flags)
 {
+    unsigned depth;
     int local_ref;
-    if(bind_local(ctx, identifier, &local_ref))
+
+    if(bind_local(ctx, identifier, &local_ref)) {
+        ctx->local_ident_cnt++;
         return push_instr_int(ctx, OP_local_ref, local_ref);
+    }
+    if(bind_outer_local(ctx, identifier, &local_ref, &depth)) {
+        ctx->outer_ident_cnt++;
+        return push_instr_int_uint(ctx, OP_outer_local_ref, local_ref, depth);
+    }
+    ctx->named_ident_cnt++;
     return push_instr_bstr_uint(ctx, OP_identid, identifier, flags);
 }
 
 static HRESULT emit_identifier(compiler_ctx_t *ctx, const WCHAR *identifier)
 {
+    unsigned depth;
     int local_ref;
-    if(bind_local(ctx, identifier, &local_ref))
+
+    if(bind_local(ctx, identifier, &local_ref)) {
+        ctx->local_ident_cnt++;
         return push_instr_int(ctx, OP_local, local_ref);
+    }
+    if(bind_outer_local(ctx, identifier, &local_ref, &depth)) {
+        ctx->outer_ident_cnt++;
+        return push_instr_int_uint(ctx, OP_outer_local, local_ref, depth);
+    }
+    ctx->named_ident_cnt++;
     return push_instr_bstr(ctx, OP_ident, identifier);
 }
 
@@ -588,6 +692,7 @@ static void pop_compiler_statement_ctx(compiler_ctx_t *ctx, statement_ctx_t *sta
 
 static HRESULT compile_memberid_expression(compiler_ctx_t *ctx, expression_t *expr, unsigned flags)
 {
+    unsigned instr;
     HRESULT hres;
 
     if(expr->type == EXPR_IDENT) {
@@ -599,7 +704,14 @@ static HRESULT compile_memberid_expression(compiler_ctx_t *ctx, expression_t *ex
     if(FAILED(hres))
         return hres;
 
-    return push_instr_uint(ctx, OP_memberid, flags);
+    instr = push_instr(ctx, OP_memberid);
+    if(!instr)
+        return E_OUTOFMEMORY;
+
+    instr_ptr(ctx, instr)->u.arg[0].uint = flags;
+    /* only accesses with a constant name can use an inline cache */
+    instr_ptr(ctx, instr)->u.arg[1].uint = expr->type == EXPR_MEMBER ? ++ctx->code->member_cache_cnt : 0;
+    return S_OK;
 }
 
 static HRESULT compile_increment_expression(compiler_ctx_t *ctx, unary_expression_t *expr, jsop_t op, int n)
@@ -1007,6 +1119,13 @@ static HRESULT compile_function_expression(compiler_ctx_t *ctx, function_express
 
     assert(ctx->current_function_expr);
 
+    ctx->current_function_expr->in_dynamic_scope = FALSE;
+    for(stat_ctx = ctx->stat_ctx; stat_ctx; stat_ctx = stat_ctx->next)
+    {
+        if(stat_ctx->using_scope && !stat_ctx->block_scope)
+            ctx->current_function_expr->in_dynamic_scope = TRUE;
+    }
+
     for(stat_ctx = ctx->stat_ctx; stat_ctx; stat_ctx = stat_ctx->next)
     {
         if(stat_ctx->block_scope)
@@ -2099,6 +2218,10 @@ static HRESULT visit_expression(compiler_ctx_t *ctx, expression_t *expr)
         hres = visit_expression(ctx, ((unary_expression_t*)expr)->expression);
         break;
     case EXPR_IDENT:
+        /* an eval call, possibly through an alias, may add variables to the function */
+        if(!wcscmp(((identifier_expression_t*)expr)->identifier, L"eval"))
+            ctx->has_eval = TRUE;
+        break;
     case EXPR_LITERAL:
     case EXPR_THIS:
         break;
@@ -2147,6 +2270,8 @@ static HRESULT visit_expression(compiler_ctx_t *ctx, expression_t *expr)
         hres = visit_function_expression(ctx, (function_expression_t*)expr);
         break;
     case EXPR_MEMBER:
+        if(!wcscmp(((member_expression_t*)expr)->identifier, L"eval"))
+            ctx->has_eval = TRUE;
         hres = visit_expression(ctx, ((member_expression_t*)expr)->expression);
         break;
     case EXPR_PROPVAL: {
@@ -2474,6 +2599,7 @@ void release_bytecode(bytecode_t *code)
     heap_pool_free(&code->heap);
     free(code->bstr_pool);
     free(code->str_pool);
+    free(code->member_caches);
     free(code->instrs);
     free(code);
 }
@@ -2517,6 +2643,7 @@ static HRESULT init_code(compiler_ctx_t *compiler, const WCHAR *source, UINT64 s
 static HRESULT compile_function(compiler_ctx_t *ctx, statement_t *source, function_expression_t *func_expr,
         BOOL from_eval, function_code_t *func)
 {
+    func_scope_t func_scope = {func, NULL, FALSE, func_expr ? func_expr->scope_index : 0, ctx->func_scope};
     function_expression_t *iter;
     function_local_t *local;
     unsigned off, i, scope;
@@ -2572,10 +2699,16 @@ static HRESULT compile_function(compiler_ctx_t *ctx, statement_t *source, functi
             return E_OUTOFMEMORY;
     }
 
+    ctx->has_eval = FALSE;
     hres = visit_block_statement(ctx, NULL, source);
     if(FAILED(hres))
         return hres;
 
+    func_scope.dynamic_scope = ctx->has_eval || (func_expr && func_expr->in_dynamic_scope);
+    if(func->name && ctx->parser->script->version >= SCRIPTLANGUAGEVERSION_ES5 &&
+       (!func_expr->is_statement || func->event_target))
+        func_scope.self_name = func->name;
+
     func->local_scope_count = ctx->local_scope_count;
     func->local_scopes = compiler_alloc(ctx->code, func->local_scope_count * sizeof(*func->local_scopes));
     if(!func->local_scopes)
@@ -2611,6 +2744,7 @@ static HRESULT compile_function(compiler_ctx_t *ctx, statement_t *source, functi
         return E_OUTOFMEMORY;
     memset(func->funcs, 0, func->func_cnt * sizeof(*func->funcs));
 
+    ctx->func_scope = &func_scope;
     ctx->current_function_expr = ctx->func_head;
     off = ctx->code_off;
     hres = compile_block_statement(ctx, NULL, source);
@@ -2629,6 +2763,7 @@ static HRESULT compile_function(compiler_ctx_t *ctx, statement_t *source, functi
     func->instr_off = off;
 
     for(iter = ctx->func_head, i=0; iter; iter = iter->next, i++) {
+        func->funcs[i].parent = func;
         hres = compile_function(ctx, iter->statement_list, iter, FALSE, func->funcs+i);
         if(FAILED(hres))
             return hres;
@@ -2649,6 +2784,7 @@ static HRESULT compile_function(compiler_ctx_t *ctx, statement_t *source, functi
 
     assert(i == func->func_cnt);
 
+    ctx->func_scope = func_scope.outer;
     return S_OK;
 }
 
@@ -2755,6 +2891,8 @@ HRESULT compile_script(script_ctx_t *ctx, const WCHAR *code, UINT64 source_conte
 
     heap_pool_init(&compiler.heap);
     hres = compile_function(&compiler, compiler.parser->source, NULL, from_eval, &compiler.code->global_code);
+    TRACE("identifiers bound to locals %u, to outer function locals %u, looked up by name %u\n",
+          compiler.local_ident_cnt, compiler.outer_ident_cnt, compiler.named_ident_cnt);
     free(compiler.local_scopes);
     heap_pool_free(&compiler.heap);
     parser_release(compiler.parser);
@@ -2766,6 +2904,12 @@ HRESULT compile_script(script_ctx_t *ctx, const WCHAR *code, UINT64 source_conte
         return DISP_E_EXCEPTION;
     }
 
+    if(compiler.code->member_cache_cnt &&
+       !(compiler.code->member_caches = calloc(compiler.code->member_cache_cnt, sizeof(*compiler.code->member_caches)))) {
+        release_bytecode(compiler.code);
+        return E_OUTOFMEMORY;
+    }
+
     if(named_item) {
         compiler.code->named_item = named_item;
         named_item->ref++;
@@ -24,6 +24,7 @@
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(jscript);
+WINE_DECLARE_DEBUG_CHANNEL(jscript_gc);
 
 static const GUID GUID_JScriptTypeInfo = {0xc59c6b12,0xf6c1,0x11cf,{0x88,0x35,0x00,0xa0,0xc9,0x11,0xe8,0xb2}};
 
@@ -210,6 +211,98 @@ static inline HRESULT resize_props(jsdisp_t *This)
     return S_OK;
 }
 
+/*
+ * Objects that got the same property names allocated in the same order share
+ * a shape, so a property index found for one of them is valid for all the
+ * others. Shapes form a transition tree owned by the script context and are
+ * only used to validate member access inline caches. Objects with too many
+ * properties, typically used as dictionaries, don't get a shape.
+ */
+#define SHAPE_TABLE_SIZE    1024
+#define MAX_SHAPE_CNT       16384
+#define MAX_SHAPE_PROP_CNT  64
+
+struct prop_shape {
+    struct prop_shape *parent;
+    struct prop_shape *next;
+    unsigned id;
+    unsigned prop_cnt;
+    unsigned hash;
+    WCHAR name[1];
+};
+
+static LONG shape_id_counter;
+
+static struct prop_shape *alloc_shape(script_ctx_t *ctx, struct prop_shape *parent, const WCHAR *name, unsigned hash)
+{
+    size_t len = name ? wcslen(name) : 0;
+    struct prop_shape *shape;
+
+    if(ctx->shape_cnt >= MAX_SHAPE_CNT || !(shape = malloc(offsetof(struct prop_shape, name[len + 1]))))
+        return NULL;
+
+    shape->parent = parent;
+    shape->next = NULL;
+    /* ids are unique across contexts, since bytecode may outlive the context */
+    shape->id = InterlockedIncrement(&shape_id_counter);
+    shape->prop_cnt = parent ? parent->prop_cnt + 1 : 0;
+    shape->hash = hash;
+    memcpy(shape->name, name ? name : L"", (len + 1) * sizeof(WCHAR));
+    ctx->shape_cnt++;
+    return shape;
+}
+
+static struct prop_shape *get_empty_shape(script_ctx_t *ctx)
+{
+    if(!ctx->empty_shape)
+        ctx->empty_shape = alloc_shape(ctx, NULL, NULL, 0);
+    return ctx->empty_shape;
+}
+
+static struct prop_shape *get_shape_transition(script_ctx_t *ctx, struct prop_shape *parent, const WCHAR *name, unsigned hash)
+{
+    struct prop_shape *shape;
+    unsigned bucket;
+
+    if(parent->prop_cnt >= MAX_SHAPE_PROP_CNT)
+        return NULL;
+
+    if(!ctx->shape_table && !(ctx->shape_table = calloc(SHAPE_TABLE_SIZE, sizeof(*ctx->shape_table))))
+        return NULL;
+
+    bucket = ((parent->id * GOLDEN_RATIO) ^ hash) & (SHAPE_TABLE_SIZE - 1);
+    for(shape = ctx->shape_table[bucket]; shape; shape = shape->next) {
+        if(shape->parent == parent && shape->hash == hash && !wcscmp(shape->name, name))
+            return shape;
+    }
+
+    if(!(shape = alloc_shape(ctx, parent, name, hash)))
+        return NULL;
+    shape->next = ctx->shape_table[bucket];
+    ctx->shape_table[bucket] = shape;
+    return shape;
+}
+
+void release_shapes(script_ctx_t *ctx)
+{
+    struct prop_shape *shape, *next;
+    unsigned i;
+
+    if(ctx->shape_table) {
+        for(i = 0; i < SHAPE_TABLE_SIZE; i++) {
+            for(shape = ctx->shape_table[i]; shape; shape = next) {
+                next = shape->next;
+                free(shape);
+            }
+        }
+        free(ctx->shape_table);
+        ctx->shape_table = NULL;
+    }
+    free(ctx->empty_shape);
+    ctx->empty_shape = NULL;
+    ctx->shape_cnt = 0;
+}
+
 static inline dispex_prop_t* alloc_prop(jsdisp_t *This, const WCHAR *name, prop_type_t type, DWORD flags)
 {
     dispex_prop_t *prop;
@@ -229,6 +322,9 @@ static inline dispex_prop_t* alloc_prop(jsdisp_t *This, const WCHAR *name, prop_
     bucket = get_props_idx(This, prop->hash);
     prop->bucket_next = This->props[bucket].bucket_head;
     This->props[bucket].bucket_head = This->prop_cnt++;
+
+    if(This->shape)
+        This->shape = get_shape_transition(This->ctx, This->shape, prop->name, prop->hash);
     return prop;
 }
 
@@ -708,11 +804,11 @@ static void unlink_jsdisp(jsdisp_t *jsdisp)
  * An "external ref" is a ref to the object that's not from any other object. Example of such
  * refs can be local variables, the script ctx (which keeps a ref to the global object), etc.
  *
- * At a high level, there are 3 logical passes done on the entire list of objects:
+ * At a high level, there are 3 logical passes done on the collected objects:
  *
- * 1. Speculatively decrease refcounts of each linked-to-object from each object. This ensures
- *    that the only remaining refcount on each object is the number of "external refs" to it.
- *    At the same time, mark all of the objects so that they can be potentially collected.
+ * 1. Mark all of the objects being collected so that they can be potentially freed, then
+ *    speculatively decrease refcounts of each marked linked-to-object from each object. This
+ *    ensures that the only remaining refcount on each object is the number of "external refs".
  *
  * 2. For each object with a non-zero "external refcount", clear the mark from step 1, and
  *    recursively traverse all linked objects from it, clearing their marks as well (regardless
@@ -728,7 +824,13 @@ static void unlink_jsdisp(jsdisp_t *jsdisp)
  * objects. Otherwise calculating the "next" object in the list becomes impossible.
  *
  * This collection process has to be done periodically, but can be pretty expensive so there
- * has to be a balance between reclaiming dangling objects and performance.
+ * has to be a balance between reclaiming dangling objects and performance. To keep the pauses
+ * short, objects are split into two generations. New objects are young and are appended to the
+ * end of the objects list, objects surviving a collection are promoted to the old generation.
+ * A young collection only marks young objects, so links from old objects are treated just like
+ * external refs and keep the linked young objects alive until the next full collection, which
+ * considers all objects. Full collections are done once the old generation grows enough since
+ * the last one, or when no collection was done for a while.
  *
  */
 struct gc_stack_chunk {
@@ -775,7 +877,23 @@ static jsdisp_t *gc_stack_pop(struct gc_ctx *gc_ctx)
     return obj;
 }
 
-HRESULT gc_run(script_ctx_t *ctx)
+/* Number of young objects triggering a collection */
+#define GC_YOUNG_LIMIT 0x10000
+
+/* Iterates objects from first to the end of the list, young objects are always at the end. */
+#define GC_FOR_EACH_OBJECT(obj, first, ctx) \
+    for(obj = (first); &obj->entry != &(ctx)->objects; obj = LIST_ENTRY(obj->entry.next, jsdisp_t, entry))
+
+static jsdisp_t *gc_first_young_object(script_ctx_t *ctx)
+{
+    struct list *iter = &ctx->objects;
+
+    while(iter->prev != &ctx->objects && LIST_ENTRY(iter->prev, jsdisp_t, entry)->gc_young)
+        iter = iter->prev;
+    return LIST_ENTRY(iter, jsdisp_t, entry);
+}
+
+static HRESULT gc_collect(script_ctx_t *ctx, BOOL full)
 {
     /* Save original refcounts in a linked list of chunks */
     struct chunk
@@ -783,10 +901,12 @@ HRESULT gc_run(script_ctx_t *ctx)
         struct chunk *next;
         LONG ref[1020];
     } *head, *chunk;
-    jsdisp_t *obj, *obj2, *link, *link2;
+    jsdisp_t *obj, *obj2, *link, *link2, *first;
     dispex_prop_t *prop, *props_end;
     struct gc_ctx gc_ctx = { 0 };
-    unsigned chunk_idx = 0;
+    unsigned chunk_idx = 0, scanned = 0, unlinked = 0, promoted = 0;
+    LARGE_INTEGER start_time, end_time, freq;
+    ULONGLONG pause;
     HRESULT hres = S_OK;
     struct list *iter;
 
@@ -794,13 +914,20 @@ HRESULT gc_run(script_ctx_t *ctx)
     if(ctx->gc_is_unlinking)
         return S_OK;
 
+    if(TRACE_ON(jscript_gc))
+        QueryPerformanceCounter(&start_time);
+
     if(!(head = malloc(sizeof(*head))))
         return E_OUTOFMEMORY;
     head->next = NULL;
     chunk = head;
 
-    /* 1. Save actual refcounts and decrease them speculatively as-if we unlinked the objects */
-    LIST_FOR_EACH_ENTRY(obj, &ctx->objects, jsdisp_t, entry) {
+    first = full ? LIST_ENTRY(ctx->objects.next, jsdisp_t, entry) : gc_first_young_object(ctx);
+
+    /* 1. Save actual refcounts and mark the objects, then decrease refcounts speculatively as-if
+          we unlinked them. Only links to marked objects are considered, so links from objects
+          outside of the collected generation behave as external refs. */
+    GC_FOR_EACH_OBJECT(obj, first, ctx) {
         if(chunk_idx == ARRAY_SIZE(chunk->ref)) {
             if(!(chunk->next = malloc(sizeof(*chunk)))) {
                 do {
@@ -808,24 +935,29 @@ HRESULT gc_run(script_ctx_t *ctx)
                     free(head);
                     head = chunk;
                 } while(head);
+                GC_FOR_EACH_OBJECT(obj, first, ctx)
+                    obj->gc_marked = FALSE;
                 return E_OUTOFMEMORY;
             }
             chunk = chunk->next; chunk_idx = 0;
             chunk->next = NULL;
         }
         chunk->ref[chunk_idx++] = obj->ref;
+        obj->gc_marked = TRUE;
+        scanned++;
     }
-    LIST_FOR_EACH_ENTRY(obj, &ctx->objects, jsdisp_t, entry) {
+
+    GC_FOR_EACH_OBJECT(obj, first, ctx) {
         for(prop = obj->props, props_end = prop + obj->prop_cnt; prop < props_end; prop++) {
             switch(prop->type) {
             case PROP_JSVAL:
-                if(is_object_instance(prop->u.val) && (link = to_jsdisp(get_object(prop->u.val))) && link->ctx == ctx)
+                if(is_object_instance(prop->u.val) && (link = to_jsdisp(get_object(prop->u.val))) && link->ctx == ctx && link->gc_marked)
                     link->ref--;
                 break;
             case PROP_ACCESSOR:
-                if(prop->u.accessor.getter && prop->u.accessor.getter->ctx == ctx)
+                if(prop->u.accessor.getter && prop->u.accessor.getter->ctx == ctx && prop->u.accessor.getter->gc_marked)
                     prop->u.accessor.getter->ref--;
-                if(prop->u.accessor.setter && prop->u.accessor.setter->ctx == ctx)
+                if(prop->u.accessor.setter && prop->u.accessor.setter->ctx == ctx && prop->u.accessor.setter->gc_marked)
                     prop->u.accessor.setter->ref--;
                 break;
             default:
@@ -833,15 +965,14 @@ HRESULT gc_run(script_ctx_t *ctx)
             }
         }
 
-        if(obj->prototype && obj->prototype->ctx == ctx)
+        if(obj->prototype && obj->prototype->ctx == ctx && obj->prototype->gc_marked)
             obj->prototype->ref--;
         if(obj->builtin_info->gc_traverse)
             obj->builtin_info->gc_traverse(&gc_ctx, GC_TRAVERSE_SPECULATIVELY, obj);
-        obj->gc_marked = TRUE;
     }
 
     /* 2. Clear mark on objects with non-zero "external refcount" and all objects accessible from them */
-    LIST_FOR_EACH_ENTRY(obj, &ctx->objects, jsdisp_t, entry) {
+    GC_FOR_EACH_OBJECT(obj, first, ctx) {
         if(!obj->ref || !obj->gc_marked)
             continue;
 
@@ -926,8 +1057,10 @@ HRESULT gc_run(script_ctx_t *ctx)
 
     /* Restore */
     chunk = head; chunk_idx = 0;
-    LIST_FOR_EACH_ENTRY(obj, &ctx->objects, jsdisp_t, entry) {
+    GC_FOR_EACH_OBJECT(obj, first, ctx) {
         obj->ref = chunk->ref[chunk_idx++];
+        if(FAILED(hres))
+            obj->gc_marked = FALSE;
         if(chunk_idx == ARRAY_SIZE(chunk->ref)) {
             struct chunk *next = chunk->next;
             free(chunk);
@@ -942,7 +1075,7 @@ HRESULT gc_run(script_ctx_t *ctx)
     /* 3. Remove all the links from the marked objects, since they are dangling */
     ctx->gc_is_unlinking = TRUE;
 
-    iter = list_head(&ctx->objects);
+    iter = &first->entry == &ctx->objects ? NULL : &first->entry;
     while(iter) {
         obj = LIST_ENTRY(iter, jsdisp_t, entry);
         if(!obj->gc_marked) {
@@ -953,6 +1086,7 @@ HRESULT gc_run(script_ctx_t *ctx)
         /* Grab it since it gets removed when unlinked */
         jsdisp_addref(obj);
         unlink_jsdisp(obj);
+        unlinked++;
 
         /* Releasing unlinked object should not delete any other object,
            so we can safely obtain the next pointer now */
@@ -961,10 +1095,53 @@ HRESULT gc_run(script_ctx_t *ctx)
     }
 
     ctx->gc_is_unlinking = FALSE;
+
+    /* Surviving young objects are promoted to the old generation */
+    LIST_FOR_EACH_ENTRY_REV(obj, &ctx->objects, jsdisp_t, entry) {
+        if(!obj->gc_young)
+            break;
+        obj->gc_young = FALSE;
+        promoted++;
+    }
+    ctx->gc_old_cnt += promoted;
+    ctx->gc_young_cnt -= promoted;
+    if(full)
+        ctx->gc_major_old_cnt = ctx->gc_old_cnt;
     ctx->gc_last_tick = GetTickCount();
+
+    if(TRACE_ON(jscript_gc)) {
+        QueryPerformanceCounter(&end_time);
+        QueryPerformanceFrequency(&freq);
+        pause = (end_time.QuadPart - start_time.QuadPart) * 1000000 / freq.QuadPart;
+        ctx->gc_stats.total_pause += pause;
+        ctx->gc_stats.max_pause = max(ctx->gc_stats.max_pause, pause);
+        if(full)
+            ctx->gc_stats.full_cnt++;
+        else
+            ctx->gc_stats.young_cnt++;
+
+        TRACE_(jscript_gc)("%s collection: scanned %u, unlinked %u, promoted %u, old %u, pause %I64u us\n",
+                           full ? "full" : "young", scanned, unlinked, promoted, ctx->gc_old_cnt, pause);
+        TRACE_(jscript_gc)("%u young and %u full collections, max pause %I64u us, total %I64u us\n",
+                           ctx->gc_stats.young_cnt, ctx->gc_stats.full_cnt, ctx->gc_stats.max_pause,
+                           ctx->gc_stats.total_pause);
+    }
     return S_OK;
 }
 
+HRESULT gc_run(script_ctx_t *ctx)
+{
+    return gc_collect(ctx, TRUE);
+}
+
+static void gc_maybe_run(script_ctx_t *ctx)
+{
+    if(GetTickCount() - ctx->gc_last_tick > 30000)
+        gc_collect(ctx, TRUE);
+    else if(ctx->gc_young_cnt >= GC_YOUNG_LIMIT)
+        gc_collect(ctx, ctx->gc_old_cnt >= ctx->gc_major_old_cnt + max(ctx->gc_major_old_cnt / 2, GC_YOUNG_LIMIT));
+}
+
 HRESULT gc_process_linked_obj(struct gc_ctx *gc_ctx, enum gc_traverse_op op, jsdisp_t *obj, jsdisp_t *link, void **unlink_ref)
 {
     if(op == GC_TRAVERSE_UNLINK) {
@@ -975,9 +1152,11 @@ HRESULT gc_process_linked_obj(struct gc_ctx *gc_ctx, enum gc_traverse_op op, jsd
 
     if(link->ctx != obj->ctx)
         return S_OK;
+    if(!link->gc_marked)
+        return S_OK;
     if(op == GC_TRAVERSE_SPECULATIVELY)
         link->ref--;
-    else if(link->gc_marked)
+    else
         return gc_stack_push(gc_ctx, link);
     return S_OK;
 }
@@ -995,9 +1174,11 @@ HRESULT gc_process_linked_val(struct gc_ctx *gc_ctx, enum gc_traverse_op op, jsd
 
     if(!is_object_instance(*link) || !(jsdisp = to_jsdisp(get_object(*link))) || jsdisp->ctx != obj->ctx)
         return S_OK;
+    if(!jsdisp->gc_marked)
+        return S_OK;
     if(op == GC_TRAVERSE_SPECULATIVELY)
         jsdisp->ref--;
-    else if(jsdisp->gc_marked)
+    else
         return gc_stack_push(gc_ctx, jsdisp);
     return S_OK;
 }
@@ -2173,9 +2354,7 @@ HRESULT init_dispex(jsdisp_t *dispex, script_ctx_t *ctx, const builtin_info_t *b
 {
     unsigned i;
 
-    /* FIXME: Use better heuristics to decide when to run the GC */
-    if(GetTickCount() - ctx->gc_last_tick > 30000)
-        gc_run(ctx);
+    gc_maybe_run(ctx);
 
     TRACE("%p (%p)\n", dispex, prototype);
 
@@ -2184,6 +2363,9 @@ HRESULT init_dispex(jsdisp_t *dispex, script_ctx_t *ctx, const builtin_info_t *b
     dispex->builtin_info = builtin_info;
     dispex->extensible = TRUE;
     dispex->prop_cnt = 0;
+    dispex->shape = get_empty_shape(ctx);
+    dispex->gc_marked = FALSE;
+    dispex->gc_young = TRUE;
 
     dispex->props = calloc(1, sizeof(dispex_prop_t)*(dispex->buf_size=4));
     if(!dispex->props)
@@ -2202,6 +2384,7 @@ HRESULT init_dispex(jsdisp_t *dispex, script_ctx_t *ctx, const builtin_info_t *b
     dispex->ctx = ctx;
 
     list_add_tail(&ctx->objects, &dispex->entry);
+    ctx->gc_young_cnt++;
     return S_OK;
 }
 
@@ -2237,6 +2420,10 @@ void jsdisp_free(jsdisp_t *obj)
     dispex_prop_t *prop;
 
     list_remove(&obj->entry);
+    if(obj->gc_young)
+        obj->ctx->gc_young_cnt--;
+    else
+        obj->ctx->gc_old_cnt--;
 
     TRACE("(%p)\n", obj);
 
@@ -2356,6 +2543,41 @@ HRESULT jsdisp_get_id(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, DISPID *
     return DISP_E_UNKNOWNNAME;
 }
 
+HRESULT jsdisp_get_id_cached(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, member_cache_t *cache, DISPID *id)
+{
+    dispex_prop_t *prop;
+    unsigned i;
+    HRESULT hres;
+
+    if(flags & fdexNameCaseInsensitive)
+        return jsdisp_get_id(jsdisp, name, flags, id);
+
+    if(jsdisp->shape) {
+        for(i = 0; i < ARRAY_SIZE(cache->entries); i++) {
+            if(cache->entries[i].shape_id != jsdisp->shape->id)
+                continue;
+
+            prop = &jsdisp->props[cache->entries[i].idx];
+            fix_protref_prop(jsdisp, prop);
+            if(prop->type == PROP_DELETED)
+                break;
+
+            *id = prop_to_id(jsdisp, prop);
+            return S_OK;
+        }
+    }
+
+    hres = jsdisp_get_id(jsdisp, name, flags, id);
+
+    /* the lookup may have allocated the property, so use the updated shape */
+    if(SUCCEEDED(hres) && jsdisp->shape) {
+        cache->entries[cache->next].shape_id = jsdisp->shape->id;
+        cache->entries[cache->next].idx = *id - 1;
+        cache->next = (cache->next + 1) % ARRAY_SIZE(cache->entries);
+    }
+    return hres;
+}
+
 HRESULT jsdisp_get_idx_id(jsdisp_t *jsdisp, DWORD idx, DISPID *id)
 {
     WCHAR name[11];
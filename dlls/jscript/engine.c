@@ -626,6 +626,18 @@ static HRESULT disp_get_id(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name
     return hres;
 }
 
+static HRESULT disp_get_member_id(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name, BSTR name_bstr,
+        DWORD flags, unsigned cache_idx, DISPID *id)
+{
+    bytecode_t *bytecode = ctx->call_ctx->bytecode;
+    jsdisp_t *jsdisp;
+
+    if(cache_idx && (jsdisp = to_jsdisp(disp)))
+        return jsdisp_get_id_cached(jsdisp, name, flags, &bytecode->member_caches[cache_idx - 1], id);
+
+    return disp_get_id(ctx, disp, name, name_bstr, flags, id);
+}
+
 static HRESULT disp_cmp(IDispatch *disp1, IDispatch *disp2, BOOL *ret)
 {
     IObjectIdentity *identity;
@@ -1431,6 +1443,7 @@ static HRESULT interp_array(script_ctx_t *ctx)
 static HRESULT interp_member(script_ctx_t *ctx)
 {
     const BSTR arg = get_op_bstr(ctx, 0);
+    const unsigned cache_idx = get_op_uint(ctx, 1);
     IDispatch *obj;
     jsval_t v;
     DISPID id;
@@ -1442,7 +1455,7 @@ static HRESULT interp_member(script_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(ctx, obj, arg, arg, 0, &id);
+    hres = disp_get_member_id(ctx, obj, arg, arg, 0, cache_idx, &id);
     if(SUCCEEDED(hres)) {
         hres = disp_propget(ctx, obj, id, &v);
     }else if(hres == DISP_E_UNKNOWNNAME) {
@@ -1460,6 +1473,7 @@ static HRESULT interp_member(script_ctx_t *ctx)
 static HRESULT interp_memberid(script_ctx_t *ctx)
 {
     const unsigned arg = get_op_uint(ctx, 0);
+    const unsigned cache_idx = get_op_uint(ctx, 1);
     jsval_t objv, namev;
     const WCHAR *name;
     jsstr_t *name_str;
@@ -1484,7 +1498,7 @@ static HRESULT interp_memberid(script_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(ctx, obj, name, NULL, arg, &id);
+    hres = disp_get_member_id(ctx, obj, name, NULL, arg, cache_idx, &id);
     jsstr_release(name_str);
     if(SUCCEEDED(hres)) {
         ref.type = EXPRVAL_IDREF;
@@ -1724,6 +1738,98 @@ static HRESULT interp_local(script_ctx_t *ctx)
     return stack_push(ctx, copy);
 }
 
+/*
+ * Looks up a variable of an enclosing function, bound by the compiler. The
+ * variable lives either on the stack of the function's frame or, once the
+ * frame got detached, in its scope object.
+ */
+static HRESULT outer_local_eval(script_ctx_t *ctx, int ref, unsigned depth, exprval_t *ret)
+{
+    const function_code_t *func = ctx->call_ctx->function;
+    scope_chain_t *scope;
+    BSTR name;
+    DISPID id;
+    HRESULT hres;
+
+    while(depth--)
+        func = func->parent;
+    name = ref < 0 ? func->params[-ref-1] : func->variables[ref].name;
+
+    for(scope = ctx->call_ctx->scope; scope; scope = scope->next) {
+        if(scope->func != func || scope->scope_index) {
+            /* eval() may have declared a variable hiding the bound one */
+            if(scope->eval_vars)
+                return identifier_eval(ctx, name, ret);
+            continue;
+        }
+
+        if(scope->frame) {
+            ret->type = EXPRVAL_STACK_REF;
+            ret->u.off = local_off(scope->frame, ref);
+            return S_OK;
+        }
+
+        if((hres = get_detached_var_dispid(scope, name, &id)) != DISP_E_UNKNOWNNAME) {
+            if(SUCCEEDED(hres))
+                exprval_set_disp_ref(ret, to_disp(&scope->dispex), id);
+            return hres;
+        }
+        if(scope->obj && SUCCEEDED(disp_get_id(ctx, scope->obj, name, name, fdexNameImplicit, &id))) {
+            exprval_set_disp_ref(ret, scope->obj, id);
+            return S_OK;
+        }
+        break;
+    }
+
+    WARN("%s not found in scope chain\n", debugstr_w(name));
+    return identifier_eval(ctx, name, ret);
+}
+
+static HRESULT interp_outer_local(script_ctx_t *ctx)
+{
+    const int arg = get_op_int(ctx, 0);
+    const unsigned depth = get_op_uint(ctx, 1);
+    exprval_t exprval;
+    jsval_t v;
+    HRESULT hres;
+
+    TRACE("%d %u\n", arg, depth);
+
+    hres = outer_local_eval(ctx, arg, depth, &exprval);
+    if(FAILED(hres))
+        return hres;
+
+    if(exprval.type == EXPRVAL_INVALID)
+        return throw_error(ctx, exprval.u.hres, NULL);
+
+    hres = exprval_to_value(ctx, &exprval, &v);
+    if(FAILED(hres))
+        return hres;
+
+    return stack_push(ctx, v);
+}
+
+static HRESULT interp_outer_local_ref(script_ctx_t *ctx)
+{
+    const int arg = get_op_int(ctx, 0);
+    const unsigned depth = get_op_uint(ctx, 1);
+    exprval_t exprval;
+    HRESULT hres;
+
+    TRACE("%d %u\n", arg, depth);
+
+    hres = outer_local_eval(ctx, arg, depth, &exprval);
+    if(FAILED(hres))
+        return hres;
+
+    if(exprval.type == EXPRVAL_INVALID) {
+        WARN("invalid ref\n");
+        exprval_set_exception(&exprval, JS_E_OBJECT_EXPECTED);
+    }
+
+    return stack_push_exprval(ctx, &exprval);
+}
+
 /* ECMA-262 3rd Edition    10.1.4 */
 static HRESULT interp_ident(script_ctx_t *ctx)
 {
@@ -3408,6 +3514,7 @@ static HRESULT setup_scope(script_ctx_t *ctx, call_frame_t *frame, scope_chain_t
     }
 
     scope->frame = frame;
+    scope->func = frame->function;
     frame->base_scope = frame->scope = scope;
     return S_OK;
 }
@@ -3462,6 +3569,8 @@ HRESULT exec_source(script_ctx_t *ctx, DWORD flags, bytecode_t *bytecode, functi
 
     if((flags & EXEC_EVAL) && ctx->call_ctx) {
         variable_obj = jsdisp_addref(ctx->call_ctx->variable_obj);
+        if(function->var_cnt && ctx->call_ctx->base_scope)
+            ctx->call_ctx->base_scope->eval_vars = TRUE;
     }else if(!(flags & (EXEC_GLOBAL | EXEC_EVAL))) {
         hres = create_dispex(ctx, NULL, NULL, &variable_obj);
         if(FAILED(hres)) return hres;
@@ -56,8 +56,8 @@
     X(lshift,     1, 0,0)                  \
     X(lt,         1, 0,0)                  \
     X(lteq,       1, 0,0)                  \
-    X(member,     1, ARG_BSTR,   0)        \
-    X(memberid,   1, ARG_UINT,   0)        \
+    X(member,     1, ARG_BSTR,   ARG_UINT) \
+    X(memberid,   1, ARG_UINT,   ARG_UINT) \
     X(minus,      1, 0,0)                  \
     X(mod,        1, 0,0)                  \
     X(mul,        1, 0,0)                  \
@@ -69,6 +69,8 @@
     X(null,       1, 0,0)                  \
     X(obj_prop,   1, ARG_STR,    ARG_UINT) \
     X(or,         1, 0,0)                  \
+    X(outer_local,     1, ARG_INT, ARG_UINT) \
+    X(outer_local_ref, 1, ARG_INT, ARG_UINT) \
     X(pop,        1, ARG_UINT,   0)        \
     X(pop_except, 0, ARG_ADDR,   0)        \
     X(pop_scope,  1, 0,0)                  \
@@ -179,6 +181,7 @@ typedef struct _function_code_t {
     unsigned local_scope_count;
 
     unsigned int scope_index; /* index of scope in the parent function where the function is defined */
+    struct _function_code_t *parent;
 
     bytecode_t *bytecode;
 } function_code_t;
@@ -208,6 +211,9 @@ struct _bytecode_t {
     unsigned str_pool_size;
     unsigned str_cnt;
 
+    member_cache_t *member_caches;
+    unsigned member_cache_cnt;
+
     struct list entry;
 };
 
@@ -232,6 +238,8 @@ typedef struct _scope_chain_t {
     jsdisp_t dispex;
     IDispatch *obj;
     unsigned int scope_index;
+    const function_code_t *func; /* function owning the scope, for function level scopes */
+    BOOL eval_vars;              /* eval() declared variables in the scope */
     struct vars_buffer *detached_vars;
     struct _call_frame_t *frame;
     struct _scope_chain_t *next;
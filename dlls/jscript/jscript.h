@@ -72,6 +72,15 @@ heap_pool_t *heap_pool_mark(heap_pool_t*);
 
 typedef struct jsdisp_t jsdisp_t;
 
+/* Inline cache of a member access site, mapping object shapes to property indexes. */
+typedef struct {
+    struct {
+        unsigned shape_id;
+        unsigned idx;
+    } entries[4];
+    unsigned next;
+} member_cache_t;
+
 extern HINSTANCE jscript_hinstance ;
 HRESULT get_dispatch_typeinfo(ITypeInfo**);
 
@@ -183,10 +192,12 @@ struct jsdisp_t {
     BOOLEAN has_weak_refs;
     BOOLEAN extensible;
     BOOLEAN gc_marked;
+    BOOLEAN gc_young;
 
     DWORD buf_size;
     DWORD prop_cnt;
     dispex_prop_t *props;
+    struct prop_shape *shape;
     script_ctx_t *ctx;
 
     jsdisp_t *prototype;
@@ -257,6 +268,7 @@ HRESULT jsdisp_propput_idx(jsdisp_t*,DWORD,jsval_t);
 HRESULT jsdisp_propget_name(jsdisp_t*,LPCWSTR,jsval_t*);
 HRESULT jsdisp_get_idx(jsdisp_t*,DWORD,jsval_t*);
 HRESULT jsdisp_get_id(jsdisp_t*,const WCHAR*,DWORD,DISPID*);
+HRESULT jsdisp_get_id_cached(jsdisp_t*,const WCHAR*,DWORD,member_cache_t*,DISPID*);
 HRESULT jsdisp_get_idx_id(jsdisp_t*,DWORD,DISPID*);
 HRESULT disp_delete(IDispatch*,DISPID,BOOL*);
 HRESULT disp_delete_name(script_ctx_t*,IDispatch*,jsstr_t*,BOOL*);
@@ -391,13 +403,32 @@ struct _script_ctx_t {
 
     heap_pool_t tmp_heap;
 
+    struct prop_shape *empty_shape;
+    struct prop_shape **shape_table;
+    unsigned shape_cnt;
+
     BOOL gc_is_unlinking;
     DWORD gc_last_tick;
+    unsigned gc_young_cnt;
+    unsigned gc_old_cnt;
+    unsigned gc_major_old_cnt;
+    struct {
+        unsigned young_cnt;
+        unsigned full_cnt;
+        ULONGLONG max_pause;
+        ULONGLONG total_pause;
+    } gc_stats;
 
     jsval_t *stack;
     unsigned stack_top;
     jsval_t acc;
 
+    struct {
+        jsstr_t *src;
+        DWORD flags;
+        struct regexp_t *regexp;
+    } regexp_cache[32];
+
     jsstr_t *last_match;
     match_result_t match_parens[9];
     DWORD last_match_index;
@@ -444,6 +475,8 @@ struct weakmap_entry {
 void remove_weakmap_entry(struct weakmap_entry*);
 
 void script_release(script_ctx_t*);
+void release_shapes(script_ctx_t*);
+void release_regexp_cache(script_ctx_t*);
 
 static inline void script_addref(script_ctx_t *ctx)
 {
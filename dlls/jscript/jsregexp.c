@@ -547,7 +547,7 @@ static void RegExp_destructor(jsdisp_t *dispex)
     RegExpInstance *This = regexp_from_jsdisp(dispex);
 
     if(This->jsregexp)
-        regexp_destroy(This->jsregexp);
+        regexp_release(This->jsregexp);
     jsval_release(This->last_index_val);
     jsstr_release(This->str);
     free(This);
@@ -629,10 +629,39 @@ static HRESULT alloc_regexp(script_ctx_t *ctx, jsstr_t *str, jsdisp_t *object_pr
     return S_OK;
 }
 
+/*
+ * Compiled patterns are cached by their source and flags, so that regular expression literals
+ * evaluated in a loop and RegExp objects created from the same string don't need to compile
+ * the pattern again. Cached patterns are shared, the cache and each instance hold a reference.
+ */
+static unsigned regexp_cache_index(script_ctx_t *ctx, const WCHAR *str, unsigned len, DWORD flags)
+{
+    unsigned i, hash = flags;
+
+    for(i = 0; i < len; i++)
+        hash = hash * 31 + str[i];
+    return hash % ARRAY_SIZE(ctx->regexp_cache);
+}
+
+void release_regexp_cache(script_ctx_t *ctx)
+{
+    unsigned i;
+
+    for(i = 0; i < ARRAY_SIZE(ctx->regexp_cache); i++) {
+        if(!ctx->regexp_cache[i].regexp)
+            continue;
+        jsstr_release(ctx->regexp_cache[i].src);
+        regexp_release(ctx->regexp_cache[i].regexp);
+        ctx->regexp_cache[i].src = NULL;
+        ctx->regexp_cache[i].regexp = NULL;
+    }
+}
+
 HRESULT create_regexp(script_ctx_t *ctx, jsstr_t *src, DWORD flags, jsdisp_t **ret)
 {
     RegExpInstance *regexp;
     const WCHAR *str;
+    unsigned idx;
     HRESULT hres;
 
     str = jsstr_flatten(src);
@@ -641,6 +670,19 @@ HRESULT create_regexp(script_ctx_t *ctx, jsstr_t *src, DWORD flags, jsdisp_t **r
 
     TRACE("%s %lx\n", debugstr_wn(str, jsstr_length(src)), flags);
 
+    idx = regexp_cache_index(ctx, str, jsstr_length(src), flags);
+    if(ctx->regexp_cache[idx].regexp && ctx->regexp_cache[idx].flags == flags
+       && jsstr_eq(ctx->regexp_cache[idx].src, src)) {
+        /* Use the cached string, compiled pattern refers to its buffer. */
+        hres = alloc_regexp(ctx, ctx->regexp_cache[idx].src, NULL, &regexp);
+        if(FAILED(hres))
+            return hres;
+
+        regexp->jsregexp = regexp_addref(ctx->regexp_cache[idx].regexp);
+        *ret = &regexp->dispex;
+        return S_OK;
+    }
+
     hres = alloc_regexp(ctx, src, NULL, &regexp);
     if(FAILED(hres))
         return hres;
@@ -652,6 +694,14 @@ HRESULT create_regexp(script_ctx_t *ctx, jsstr_t *src, DWORD flags, jsdisp_t **r
         return DISP_E_EXCEPTION;
     }
 
+    if(ctx->regexp_cache[idx].regexp) {
+        jsstr_release(ctx->regexp_cache[idx].src);
+        regexp_release(ctx->regexp_cache[idx].regexp);
+    }
+    ctx->regexp_cache[idx].src = jsstr_addref(regexp->str);
+    ctx->regexp_cache[idx].flags = flags;
+    ctx->regexp_cache[idx].regexp = regexp_addref(regexp->jsregexp);
+
     *ret = &regexp->dispex;
     return S_OK;
 }
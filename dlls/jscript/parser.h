@@ -302,6 +302,7 @@ typedef struct _function_expression_t {
     unsigned func_id;
     BOOL is_statement;
     unsigned int scope_index;
+    BOOL in_dynamic_scope;
 
     struct _function_expression_t *next; /* for compiler */
 } function_expression_t;
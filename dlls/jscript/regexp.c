@@ -32,6 +32,7 @@
  */
 
 #include <assert.h>
+#include <wchar.h>
 
 #include "jscript.h"
 #include "regexp.h"
@@ -3067,8 +3068,26 @@ good:
     return x;
 }
 
+/*
+ * Find the required literal prefix computed by InitPrefix, so that we don't
+ * need to try to match at positions where the match can't start.
+ */
+static const WCHAR *FindPrefix(const regexp_t *re, const WCHAR *cp, const WCHAR *cpend)
+{
+    while ((size_t)(cpend - cp) >= re->prefix_len) {
+        cp = wmemchr(cp, re->prefix[0], cpend - cp - re->prefix_len + 1);
+        if (!cp)
+            return NULL;
+        if (!wmemcmp(cp + 1, re->prefix + 1, re->prefix_len - 1))
+            return cp;
+        cp++;
+    }
+    return NULL;
+}
+
 static match_state_t *MatchRegExp(REGlobalData *gData, match_state_t *x)
 {
+    const regexp_t *re = gData->regexp;
     match_state_t *result;
     const WCHAR *cp = x->cp;
     const WCHAR *cp2;
@@ -3079,6 +3098,12 @@ static match_state_t *MatchRegExp(REGlobalData *gData, match_state_t *x)
      * in order to detect end-of-input/line condition.
      */
     for (cp2 = cp; cp2 <= gData->cpend; cp2++) {
+        /* A pattern starting with ^ can only match at the beginning of input without multiline flag. */
+        if (re->program[0] == REOP_BOL && !(re->flags & REG_MULTILINE) && cp2 != gData->cpbegin)
+            return NULL;
+        if (re->prefix_len && !(re->flags & REG_STICKY) && !(cp2 = FindPrefix(re, cp2, gData->cpend)))
+            return NULL;
+
         gData->skipped = cp2 - cp;
         x->cp = cp2;
         for (j = 0; j < gData->regexp->parenCount; j++)
@@ -3174,8 +3199,11 @@ HRESULT regexp_execute(regexp_t *regexp, void *cx, heap_pool_t *pool,
     return S_OK;
 }
 
-void regexp_destroy(regexp_t *re)
+void regexp_release(regexp_t *re)
 {
+    if (--re->ref)
+        return;
+
     if (re->classList) {
         UINT i;
         for (i = 0; i < re->classCount; i++) {
@@ -3188,6 +3216,43 @@ void regexp_destroy(regexp_t *re)
     free(re);
 }
 
+/*
+ * Find a literal string that every match has to start with. This is used by
+ * MatchRegExp to skip positions at which a match can't start.
+ */
+static void InitPrefix(regexp_t *re)
+{
+    jsbytecode *pc = re->program;
+    size_t index, length;
+
+    re->prefix = NULL;
+    re->prefix_len = 0;
+
+    while (*pc == REOP_LPAREN)
+        pc = ReadCompactIndex(pc + 1, &index);
+
+    switch (*pc++) {
+      case REOP_FLAT:
+        pc = ReadCompactIndex(pc, &index);
+        ReadCompactIndex(pc, &length);
+        re->prefix = re->source + index;
+        re->prefix_len = length;
+        break;
+      case REOP_FLAT1:
+        re->prefix_chr = *pc;
+        re->prefix = &re->prefix_chr;
+        re->prefix_len = 1;
+        break;
+      case REOP_UCFLAT1:
+        re->prefix_chr = GET_ARG(pc);
+        re->prefix = &re->prefix_chr;
+        re->prefix_len = 1;
+        break;
+      default:
+        break;
+    }
+}
+
 regexp_t* regexp_new(void *cx, heap_pool_t *pool, const WCHAR *str,
         DWORD str_len, WORD flags, BOOL flat)
 {
@@ -3237,13 +3302,14 @@ regexp_t* regexp_new(void *cx, heap_pool_t *pool, const WCHAR *str,
     re = malloc(resize);
     if (!re)
         goto out;
+    re->ref = 1;
 
     assert(state.classBitmapsMem <= CLASS_BITMAPS_MEM_LIMIT);
     re->classCount = state.classCount;
     if (re->classCount) {
         re->classList = malloc(re->classCount * sizeof(RECharSet));
         if (!re->classList) {
-            regexp_destroy(re);
+            regexp_release(re);
             re = NULL;
             goto out;
         }
@@ -3254,7 +3320,7 @@ regexp_t* regexp_new(void *cx, heap_pool_t *pool, const WCHAR *str,
     }
     endPC = EmitREBytecode(&state, re, state.treeDepth, re->program, state.result);
     if (!endPC) {
-        regexp_destroy(re);
+        regexp_release(re);
         re = NULL;
         goto out;
     }
@@ -3277,6 +3343,7 @@ regexp_t* regexp_new(void *cx, heap_pool_t *pool, const WCHAR *str,
     re->parenCount = state.parenCount;
     re->source = str;
     re->source_len = str_len;
+    InitPrefix(re);
 
 out:
     heap_pool_clear(mark);
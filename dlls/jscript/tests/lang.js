@@ -2081,6 +2081,160 @@ function returnTest() {
 
 ok(returnTest() === undefined, "returnTest = " + returnTest());
 
+function test_member_cache() {
+    var i, objs, proto, o, r;
+
+    function getX(obj) {
+        return obj.x;
+    }
+
+    function setX(obj, v) {
+        obj.x = v;
+    }
+
+    /* same call sites used with different property layouts */
+    objs = [{x: 1}, {y: 2, x: 3}, {a: 0, b: 0, x: 5}, {z: 6}, {b: 0, a: 0, x: 7}, {x: 8, y: 9}];
+    for(i = 0; i < 3; i++) {
+        ok(getX(objs[0]) === 1, "getX(objs[0]) = " + getX(objs[0]));
+        ok(getX(objs[1]) === 3, "getX(objs[1]) = " + getX(objs[1]));
+        ok(getX(objs[2]) === 5, "getX(objs[2]) = " + getX(objs[2]));
+        ok(getX(objs[3]) === undefined, "getX(objs[3]) = " + getX(objs[3]));
+        ok(getX(objs[4]) === 7, "getX(objs[4]) = " + getX(objs[4]));
+        ok(getX(objs[5]) === 8, "getX(objs[5]) = " + getX(objs[5]));
+    }
+
+    for(i = 0; i < objs.length; i++)
+        setX(objs[i], i);
+    for(i = 0; i < objs.length; i++)
+        ok(getX(objs[i]) === i, "getX(objs[" + i + "]) = " + getX(objs[i]));
+
+    /* deleted properties */
+    o = {x: 1, y: 2};
+    ok(getX(o) === 1, "getX(o) = " + getX(o));
+    delete o.x;
+    ok(getX(o) === undefined, "getX(o) after delete = " + getX(o));
+    setX(o, 3);
+    ok(getX(o) === 3, "getX(o) after set = " + getX(o));
+
+    /* properties found in prototypes */
+    function C() {}
+    proto = {x: "proto"};
+    C.prototype = proto;
+    o = new C();
+    r = new C();
+    ok(getX(o) === "proto", "getX(o) = " + getX(o));
+    ok(getX(r) === "proto", "getX(r) = " + getX(r));
+    proto.x = "changed";
+    ok(getX(o) === "changed", "getX(o) = " + getX(o));
+    setX(o, "own");
+    ok(getX(o) === "own", "getX(o) = " + getX(o));
+    ok(getX(r) === "changed", "getX(r) = " + getX(r));
+    delete proto.x;
+    ok(getX(r) === undefined, "getX(r) after delete = " + getX(r));
+    ok(getX(o) === "own", "getX(o) = " + getX(o));
+
+    /* same layout, different prototypes */
+    function D() {}
+    D.prototype = {x: "D"};
+    o = new C();
+    r = new D();
+    proto.x = "C";
+    for(i = 0; i < 2; i++) {
+        ok(getX(o) === "C", "getX(o) = " + getX(o));
+        ok(getX(r) === "D", "getX(r) = " + getX(r));
+    }
+}
+
+test_member_cache();
+
+function test_outer_locals() {
+    var x = 1, r, counter, inc;
+
+    function get_x() {
+        return x;
+    }
+
+    function nested(a) {
+        var y = 2;
+        return function() {
+            x++;
+            return x + y + a;
+        }
+    }
+
+    ok(get_x() === 1, "get_x() = " + get_x());
+    x = 2;
+    ok(get_x() === 2, "get_x() = " + get_x());
+    r = nested(3);
+    ok(r() === 8, "r() = " + r());
+    ok(x === 4, "x = " + x);
+
+    function make_counter() {
+        var n = 0;
+        return function() { return ++n; }
+    }
+    counter = make_counter();
+    counter();
+    ok(counter() === 2, "counter() = " + counter());
+
+    /* variables added by eval in an intermediate function */
+    function eval_scope() {
+        eval("var x = 'eval';");
+        return function() { return x; }
+    }
+    ok(eval_scope()() === "eval", "eval_scope()() = " + eval_scope()());
+
+    /* eval called through an alias runs in the caller's scope too */
+    function alias_eval_scope() {
+        eval_alias("var x = 'alias';");
+        return function() { return x; }
+    }
+    ok(alias_eval_scope()() === "alias", "alias_eval_scope()() = " + alias_eval_scope()());
+    ok(x === 4, "x = " + x);
+
+    /* with and catch scopes shadowing outer variables */
+    function with_scope() {
+        with({x: "with"}) {
+            return function() { return x; }
+        }
+    }
+    ok(with_scope()() === "with", "with_scope()() = " + with_scope()());
+
+    function catch_scope() {
+        try {
+            throw "catch";
+        }catch(x) {
+            return function() { return x; }
+        }
+    }
+    ok(catch_scope()() === "catch", "catch_scope()() = " + catch_scope()());
+
+    function with_inner() {
+        var o = {x: "with inner"};
+        with(o)
+            return x;
+    }
+    ok(with_inner() === "with inner", "with_inner() = " + with_inner());
+
+    /* assignments through a detached scope */
+    inc = (function() {
+        var v = 10;
+        function g() { return v; }
+        return function() { v++; return g(); }
+    })();
+    inc();
+    ok(inc() === 12, "inc() = " + inc());
+
+    /* recursion through an outer variable */
+    function fact(n) {
+        return n > 1 ? n * fact(n - 1) : 1;
+    }
+    ok(fact(5) === 120, "fact(5) = " + fact(5));
+}
+
+var eval_alias = eval;
+test_outer_locals();
+
 ActiveXObject = 1;
 ok(ActiveXObject === 1, "ActiveXObject = " + ActiveXObject);
 
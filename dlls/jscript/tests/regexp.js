@@ -732,4 +732,35 @@ ok(re.ignoreCase === false, "re.ignoreCase = " + re.ignoreCase);
 ok(re.multiline === true, "re.multiline = " + re.multiline);
 ok(re.global === true, "re.global = " + re.global);
 
+re = /(abc)d/g;
+ok(re.exec("xxabcdyyabcd").index === 2, "first abcd match index != 2");
+ok(re.lastIndex === 6, "re.lastIndex = " + re.lastIndex);
+ok(re.exec("xxabcdyyabcd").index === 8, "second abcd match index != 8");
+ok(re.exec("xxabcdyyabcd") === null, "expected no more abcd matches");
+ok(re.exec("abcabcabd") === null, "abcabcabd matched");
+
+re = /^a/g;
+re.lastIndex = 1;
+ok(re.exec("aaa") === null, "^a matched at lastIndex 1");
+re = /^a/mg;
+re.lastIndex = 1;
+ok(re.exec("a\na").index === 2, "^a with multiline flag did not match at 2");
+
+ok("x\u0100y\u0100".replace(/\u0100/g, "-") === "x-y-", "unexpected \\u0100 replace result");
+ok("a.b.c".replace(/\./g, "") === "abc", "unexpected \\. replace result");
+ok("aBcabc".replace(/bc/gi, "") === "aa", "unexpected /bc/gi replace result");
+
+for(i = 0; i < 3; i++) {
+    re = /b+/g;
+    ok(re.lastIndex === 0, "re.lastIndex = " + re.lastIndex + " in iteration " + i);
+    ok(re.exec("abbc")[0] === "bb", "unexpected b+ match in iteration " + i);
+    ok(re.lastIndex === 3, "re.lastIndex = " + re.lastIndex + " in iteration " + i);
+}
+re = new RegExp("b+", "g");
+tmp = new RegExp("b+", "g");
+re.exec("abbc");
+ok(tmp.lastIndex === 0, "tmp.lastIndex = " + tmp.lastIndex);
+ok(re.source === "b+" && tmp.source === "b+", "unexpected source");
+ok(new RegExp("b+").global === false, "RegExp(\"b+\").global = true");
+
 reportSuccess();
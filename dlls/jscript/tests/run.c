@@ -3644,6 +3644,104 @@ static void test_destructors(void)
     IActiveScript_Release(script);
 }
 
+static void test_gc_generations(void)
+{
+    IActiveScriptParse *parser;
+    IActiveScript *script;
+    VARIANT v;
+    HRESULT hres;
+
+    /* garbage is collected while objects are allocated, without waiting for CollectGarbage */
+    SET_EXPECT(testdestrobj);
+    V_VT(&v) = VT_EMPTY;
+    hres = parse_script_expr(L"(function() {\n"
+        "var a = { 'obj': testDestrObj }; a.self = a;\n"
+        "for(var i = 0; i < 0x20000; i++) a = {};\n"
+    "})(), true", &v, &script);
+    ok(hres == S_OK, "parse_script_expr failed: %08lx\n", hres);
+    ok(V_VT(&v) == VT_BOOL, "V_VT(v) = %d\n", V_VT(&v));
+    CHECK_CALLED(testdestrobj);
+    close_script(script);
+
+    /* objects only referenced by objects surviving earlier collections stay alive */
+    V_VT(&v) = VT_EMPTY;
+    hres = parse_script_expr(L"(function() {\n"
+        "var o, i; Math.old = {};\n"
+        "for(i = 0; i < 0x20000; i++) o = {};\n"
+        "Math.old.young = { 'obj': testDestrObj }; Math.old.young.self = Math.old.young;\n"
+        "for(i = 0; i < 0x20000; i++) o = {};\n"
+    "})(), Math.old.young.obj === testDestrObj", &v, &script);
+    ok(hres == S_OK, "parse_script_expr failed: %08lx\n", hres);
+    ok(V_VT(&v) == VT_BOOL, "V_VT(v) = %d\n", V_VT(&v));
+    ok(V_BOOL(&v) == VARIANT_TRUE, "V_BOOL(v) = %x\n", V_BOOL(&v));
+    ok(test_destr_ref > 0, "testDestrObj was released\n");
+
+    /* and cycles between them are collected once unreachable */
+    hres = IActiveScript_QueryInterface(script, &IID_IActiveScriptParse, (void**)&parser);
+    ok(hres == S_OK, "Could not get IActiveScriptParse: %08lx\n", hres);
+
+    SET_EXPECT(testdestrobj);
+    V_VT(&v) = VT_EMPTY;
+    hres = IActiveScriptParse_ParseScriptText(parser, L"(function() {\n"
+        "var o, i; Math.old.young.old = Math.old; Math.old = undefined;\n"
+        "for(i = 0; i < 0x20000; i++) o = {};\n"
+    "})(), CollectGarbage(), true", NULL, NULL, NULL, 0, 0, SCRIPTTEXT_ISEXPRESSION, &v, NULL);
+    ok(hres == S_OK, "ParseScriptText failed: %08lx\n", hres);
+    ok(V_VT(&v) == VT_BOOL, "V_VT(v) = %d\n", V_VT(&v));
+    IActiveScriptParse_Release(parser);
+    CHECK_CALLED(testdestrobj);
+
+    close_script(script);
+}
+
+static void test_es5_block_scopes(void)
+{
+    IActiveScriptParse *parser;
+    IActiveScript *engine;
+    VARIANT v;
+    HRESULT hres;
+
+    hres = CoCreateInstance(engine_clsid, NULL, CLSCTX_INPROC_SERVER|CLSCTX_INPROC_HANDLER,
+            &IID_IActiveScript, (void**)&engine);
+    ok(hres == S_OK, "CoCreateInstance failed: %08lx\n", hres);
+
+    /* ES5 mode, used by mshtml in IE9+ document modes */
+    V_VT(&v) = VT_I4;
+    V_I4(&v) = 0x400 | 0x102;
+    hres = set_script_prop(engine, SCRIPTPROP_INVOKEVERSIONING, &v);
+    if(FAILED(hres)) {
+        win_skip("ES5 mode not supported\n");
+        IActiveScript_Release(engine);
+        return;
+    }
+
+    hres = IActiveScript_QueryInterface(engine, &IID_IActiveScriptParse, (void**)&parser);
+    ok(hres == S_OK, "Could not get IActiveScriptParse: %08lx\n", hres);
+
+    hres = IActiveScriptParse_InitNew(parser);
+    ok(hres == S_OK, "InitNew failed: %08lx\n", hres);
+
+    hres = IActiveScript_SetScriptSite(engine, &ActiveScriptSite);
+    ok(hres == S_OK, "SetScriptSite failed: %08lx\n", hres);
+
+    hres = IActiveScript_SetScriptState(engine, SCRIPTSTATE_STARTED);
+    ok(hres == S_OK, "SetScriptState(SCRIPTSTATE_STARTED) failed: %08lx\n", hres);
+
+    /* let variables shadowing a function level variable seen from a closure */
+    hres = IActiveScriptParse_ParseScriptText(parser,
+            L"function g() { var x = 1; { let x = 2; var f = function() { return x; }; } return f(); }\n"
+            L"if(g() !== 2) throw 'g() = ' + g();\n"
+            L"function h() { var x = 1; var f; { let x = 2; { let y = 3; f = function() { return x + y; }; } } return f(); }\n"
+            L"if(h() !== 5) throw 'h() = ' + h();\n"
+            L"function k() { var x = 1; { let x = 2; } return function() { return x; }; }\n"
+            L"if(k()() !== 1) throw 'k()() = ' + k()();\n",
+            NULL, NULL, NULL, 0, 0, 0, NULL, NULL);
+    ok(hres == S_OK, "ParseScriptText failed: %08lx\n", hres);
+
+    IActiveScriptParse_Release(parser);
+    IActiveScript_Release(engine);
+}
+
 static void test_eval(void)
 {
     IActiveScriptParse *parser;
@@ -4173,7 +4271,9 @@ static BOOL run_tests(void)
     test_script_exprs();
     test_invokeex();
     test_destructors();
+    test_gc_generations();
     test_eval();
+    test_es5_block_scopes();
     test_error_reports();
 
     run_bom_tests();
@@ -4270,12 +4370,11 @@ static void run_encoded_tests(void)
     ok(hres == JS_E_INVALID_CHAR, "parse_script failed %08lx\n", hres);
 }
 
-static void run_benchmark(const char *script_name)
+static void run_benchmark_src(const char *name, const WCHAR *src)
 {
     IActiveScriptParse *parser;
     IActiveScript *engine;
     ULONG start, end;
-    BSTR src;
     HRESULT hres;
 
     engine = create_script();
@@ -4302,17 +4401,22 @@ static void run_benchmark(const char *script_name)
     hres = IActiveScript_SetScriptState(engine, SCRIPTSTATE_STARTED);
     ok(hres == S_OK, "SetScriptState(SCRIPTSTATE_STARTED) failed: %08lx\n", hres);
 
-    src = load_res(script_name);
-
     start = GetTickCount();
     hres = IActiveScriptParse_ParseScriptText(parser, src, NULL, NULL, NULL, 0, 0, 0, NULL, NULL);
     end = GetTickCount();
-    ok(hres == S_OK, "%s: ParseScriptText failed: %08lx\n", script_name, hres);
+    ok(hres == S_OK, "%s: ParseScriptText failed: %08lx\n", name, hres);
 
-    trace("%s ran in %lu ms\n", script_name, end-start);
+    trace("%s ran in %lu ms\n", name, end-start);
 
     IActiveScript_Release(engine);
     IActiveScriptParse_Release(parser);
+}
+
+static void run_benchmark(const char *script_name)
+{
+    BSTR src = load_res(script_name);
+
+    run_benchmark_src(script_name, src);
     SysFreeString(src);
 }
 
@@ -4323,6 +4427,20 @@ static void run_benchmarks(void)
     run_benchmark("dna.js");
     run_benchmark("base64.js");
     run_benchmark("validateinput.js");
+
+    /* member access on objects sharing a layout, exercises the inline caches */
+    run_benchmark_src("member get", L"function P(x, y) { this.x = x; this.y = y; }\n"
+                      L"var a = [], s = 0, i, j;\n"
+                      L"for(i = 0; i < 100; i++) a.push(new P(i, 2 * i));\n"
+                      L"for(j = 0; j < 2000; j++) for(i = 0; i < 100; i++) s += a[i].x + a[i].y;\n");
+    run_benchmark_src("member put", L"var o = { a: 0, b: 0, c: 0 }, i;\n"
+                      L"for(i = 0; i < 200000; i++) { o.a = i; o.b = o.a; o.c = o.b; }\n");
+    run_benchmark_src("prototype call", L"function P() { this.v = 1; }\n"
+                      L"P.prototype.get = function() { return this.v; };\n"
+                      L"var o = new P(), s = 0, i;\n"
+                      L"for(i = 0; i < 200000; i++) s += o.get();\n");
+    run_benchmark_src("polymorphic get", L"var a = [{ x: 1 }, { y: 1, x: 2 }, { z: 1, y: 1, x: 3 }], s = 0, i;\n"
+                      L"for(i = 0; i < 200000; i++) s += a[i % 3].x;\n");
 }
 
 static BOOL check_jscript(void)
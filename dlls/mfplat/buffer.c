@@ -28,6 +28,8 @@
 #include "d3d9.h"
 #include "evr.h"
 
+#include "wine/list.h"
+
 WINE_DEFAULT_DEBUG_CHANNEL(mfplat);
 
 #define ALIGN_SIZE(size, alignment) (((size) + (alignment)) & ~((alignment)))
@@ -43,6 +45,8 @@ struct buffer
     LONG refcount;
 
     BYTE *data;
+    SIZE_T data_size;
+    DWORD data_alignment;
     DWORD max_length;
     DWORD current_length;
 
@@ -76,6 +80,114 @@ struct buffer
     CRITICAL_SECTION cs;
 };
 
+/* Large buffers, typically video frames, are recycled instead of going back to the heap.
+   Free blocks are kept on a list, rounded up to a page size, up to a total size limit. */
+#define BUFFER_POOL_MIN_SIZE 0x10000
+#define BUFFER_POOL_DEFAULT_LIMIT (64 * 1024 * 1024)
+
+struct pooled_block
+{
+    struct list entry;
+    SIZE_T size;
+    DWORD alignment;
+};
+
+static struct list pooled_blocks = LIST_INIT(pooled_blocks);
+static SIZE_T buffer_pool_size, buffer_pool_limit;
+static LONG buffer_pool_allocations, buffer_pool_hits;
+static INIT_ONCE buffer_pool_init_once = INIT_ONCE_STATIC_INIT;
+
+static CRITICAL_SECTION buffer_pool_cs;
+static CRITICAL_SECTION_DEBUG buffer_pool_cs_debug =
+{
+    0, 0, &buffer_pool_cs,
+    { &buffer_pool_cs_debug.ProcessLocksList, &buffer_pool_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": buffer_pool_cs") }
+};
+static CRITICAL_SECTION buffer_pool_cs = { &buffer_pool_cs_debug, -1, 0, 0, 0, 0 };
+
+static BOOL WINAPI buffer_pool_init(INIT_ONCE *once, void *param, void **context)
+{
+    DWORD size = sizeof(DWORD), limit;
+
+    /* Limit is in megabytes, 0 disables pooling. */
+    if (!RegGetValueW(HKEY_CURRENT_USER, L"Software\\Wine\\MediaFoundation", L"BufferPoolSize",
+            RRF_RT_REG_DWORD, NULL, &limit, &size))
+        buffer_pool_limit = (SIZE_T)limit * 1024 * 1024;
+    else
+        buffer_pool_limit = BUFFER_POOL_DEFAULT_LIMIT;
+
+    TRACE("Using buffer pool limit %#Ix.\n", buffer_pool_limit);
+
+    return TRUE;
+}
+
+static BYTE *buffer_pool_alloc(SIZE_T length, DWORD alignment, SIZE_T *size)
+{
+    struct pooled_block *block;
+    LONG allocations;
+
+    if (length < BUFFER_POOL_MIN_SIZE)
+    {
+        *size = length;
+        return _aligned_malloc(length, alignment);
+    }
+
+    InitOnceExecuteOnce(&buffer_pool_init_once, buffer_pool_init, NULL, NULL);
+
+    *size = (length + 0xfff) & ~(SIZE_T)0xfff;
+    allocations = InterlockedIncrement(&buffer_pool_allocations);
+
+    EnterCriticalSection(&buffer_pool_cs);
+    LIST_FOR_EACH_ENTRY(block, &pooled_blocks, struct pooled_block, entry)
+    {
+        if (block->size == *size && block->alignment == alignment)
+        {
+            list_remove(&block->entry);
+            buffer_pool_size -= block->size;
+            LeaveCriticalSection(&buffer_pool_cs);
+            InterlockedIncrement(&buffer_pool_hits);
+            return (BYTE *)block;
+        }
+    }
+    LeaveCriticalSection(&buffer_pool_cs);
+
+    TRACE("Allocating %#Ix bytes, %ld of %ld allocations reused, %#Ix bytes pooled.\n", *size,
+            buffer_pool_hits, allocations, buffer_pool_size);
+
+    return _aligned_malloc(*size, alignment);
+}
+
+static void buffer_pool_free(BYTE *data, SIZE_T size, DWORD alignment)
+{
+    struct pooled_block *block = (struct pooled_block *)data, *oldest;
+
+    if (!data)
+        return;
+
+    if (size >= BUFFER_POOL_MIN_SIZE && size <= buffer_pool_limit)
+    {
+        block->size = size;
+        block->alignment = alignment;
+
+        EnterCriticalSection(&buffer_pool_cs);
+        list_add_head(&pooled_blocks, &block->entry);
+        buffer_pool_size += size;
+        /* Drop least recently released blocks first. */
+        while (buffer_pool_size > buffer_pool_limit)
+        {
+            oldest = LIST_ENTRY(list_tail(&pooled_blocks), struct pooled_block, entry);
+            list_remove(&oldest->entry);
+            buffer_pool_size -= oldest->size;
+            _aligned_free(oldest);
+        }
+        LeaveCriticalSection(&buffer_pool_cs);
+        return;
+    }
+
+    _aligned_free(data);
+}
+
 static void copy_image(const struct buffer *buffer, BYTE *dest, LONG dest_stride, const BYTE *src,
         LONG src_stride, DWORD width, DWORD lines)
 {
@@ -173,7 +285,7 @@ static ULONG WINAPI memory_buffer_Release(IMFMediaBuffer *iface)
         }
         DeleteCriticalSection(&buffer->cs);
         free(buffer->_2d.linear_buffer);
-        _aligned_free(buffer->data);
+        buffer_pool_free(buffer->data, buffer->data_size, buffer->data_alignment);
         free(buffer);
     }
 
@@ -1334,8 +1446,9 @@ static HRESULT memory_buffer_init(struct buffer *buffer, DWORD max_length, DWORD
         alignment++;
     }
 
-    if (!(buffer->data = _aligned_malloc(max_length, alignment)))
+    if (!(buffer->data = buffer_pool_alloc(max_length, alignment, &buffer->data_size)))
         return E_OUTOFMEMORY;
+    buffer->data_alignment = alignment;
     memset(buffer->data, 0, max_length);
 
     buffer->IMFMediaBuffer_iface.lpVtbl = vtbl;
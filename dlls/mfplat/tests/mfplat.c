@@ -2572,6 +2572,25 @@ static void test_system_memory_aligned_buffer(void)
         IMFMediaBuffer_Release(buffer);
     }
 
+    /* Large buffers, released and created again with different alignments. */
+    for (i = 0; i < 2 * ARRAY_SIZE(alignments); ++i)
+    {
+        DWORD alignment = alignments[i % ARRAY_SIZE(alignments)];
+
+        hr = MFCreateAlignedMemoryBuffer(0x100000, alignment, &buffer);
+        ok(hr == S_OK, "Failed to create memory buffer, hr %#lx.\n", hr);
+
+        hr = IMFMediaBuffer_Lock(buffer, &data, &max, &length);
+        ok(hr == S_OK, "Failed to lock, hr %#lx.\n", hr);
+        ok(max == 0x100000 && !length, "Unexpected length.\n");
+        ok(!((uintptr_t)data & alignment), "Data at %p is misaligned.\n", data);
+        memset(data, 0xcc, max);
+        hr = IMFMediaBuffer_Unlock(buffer);
+        ok(hr == S_OK, "Failed to unlock, hr %#lx.\n", hr);
+
+        IMFMediaBuffer_Release(buffer);
+    }
+
     hr = MFCreateAlignedMemoryBuffer(200, 0, &buffer);
     ok(hr == S_OK, "Failed to create memory buffer, hr %#lx.\n", hr);
     IMFMediaBuffer_Release(buffer);
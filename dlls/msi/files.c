@@ -472,6 +472,138 @@ static UINT copy_install_file(MSIPACKAGE *package, MSIFILE *file, LPWSTR source)
     return gle;
 }
 
+/*
+ * Uncompressed files are copied on a thread pool, while the installer thread
+ * keeps sending progress messages and extracting cabinets, whose folders are
+ * decompressed on the same pool. Copy jobs are completed in file order once
+ * they are all done, and copies that failed are retried serially with
+ * copy_install_file, which handles files in use.
+ */
+struct copy_job
+{
+    struct list entry;
+    MSIPACKAGE *package;
+    MSIFILE *file;
+    WCHAR *source;
+    UINT rc;
+};
+
+struct copy_queue
+{
+    TP_CALLBACK_ENVIRON env;
+    PTP_POOL pool;
+    PTP_CLEANUP_GROUP group;
+    struct list jobs;
+    UINT disk_id;
+    UINT count;
+    ULONGLONG start;
+};
+
+static void CALLBACK copy_job_cb( TP_CALLBACK_INSTANCE *instance, void *context )
+{
+    struct copy_job *job = context;
+    BOOL redirect = is_wow64 && job->package->platform == PLATFORM_X64;
+    void *cookie;
+
+    /* the package cookie is used by the installer thread, don't share it */
+    if (redirect) Wow64DisableWow64FsRedirection( &cookie );
+    if (CopyFileW( job->source, job->file->TargetPath, FALSE ))
+    {
+        SetFileAttributesW( job->file->TargetPath, FILE_ATTRIBUTE_NORMAL );
+        job->rc = ERROR_SUCCESS;
+    }
+    else job->rc = GetLastError();
+    if (redirect) Wow64RevertWow64FsRedirection( cookie );
+}
+
+static struct copy_queue *create_copy_queue(void)
+{
+    struct copy_queue *queue;
+    SYSTEM_INFO info;
+
+    if (!(queue = calloc( 1, sizeof(*queue) ))) return NULL;
+
+    GetSystemInfo( &info );
+    if (!(queue->pool = CreateThreadpool( NULL )) || !(queue->group = CreateThreadpoolCleanupGroup()))
+    {
+        if (queue->pool) CloseThreadpool( queue->pool );
+        free( queue );
+        return NULL;
+    }
+    SetThreadpoolThreadMaximum( queue->pool, max( 1, info.dwNumberOfProcessors ) );
+
+    InitializeThreadpoolEnvironment( &queue->env );
+    SetThreadpoolCallbackPool( &queue->env, queue->pool );
+    SetThreadpoolCallbackCleanupGroup( &queue->env, queue->group, NULL );
+    list_init( &queue->jobs );
+    return queue;
+}
+
+static BOOL queue_copy_file( struct copy_queue *queue, MSIPACKAGE *package, MSIFILE *file, WCHAR *source, UINT disk_id )
+{
+    struct copy_job *job;
+
+    if (!queue || !(job = malloc( sizeof(*job) ))) return FALSE;
+
+    job->package = package;
+    job->file = file;
+    job->source = source;
+    job->rc = ERROR_IO_PENDING;
+    if (!TrySubmitThreadpoolCallback( copy_job_cb, job, &queue->env ))
+    {
+        free( job );
+        return FALSE;
+    }
+    if (!queue->count++) queue->start = GetTickCount64();
+    queue->disk_id = disk_id;
+    list_add_tail( &queue->jobs, &job->entry );
+    return TRUE;
+}
+
+static UINT finish_copy_queue( struct copy_queue *queue, MSIPACKAGE *package )
+{
+    struct copy_job *job, *next;
+    UINT rc = ERROR_SUCCESS;
+
+    if (!queue || list_empty( &queue->jobs )) return ERROR_SUCCESS;
+
+    CloseThreadpoolCleanupGroupMembers( queue->group, FALSE, NULL );
+    TRACE("copied %u files in %I64u ms\n", queue->count, GetTickCount64() - queue->start);
+
+    LIST_FOR_EACH_ENTRY_SAFE( job, next, &queue->jobs, struct copy_job, entry )
+    {
+        if (rc == ERROR_SUCCESS && job->rc != ERROR_SUCCESS)
+        {
+            TRACE("retrying copy of %s to %s (%u)\n", debugstr_w(job->source),
+                  debugstr_w(job->file->TargetPath), job->rc);
+            if ((job->rc = copy_install_file( package, job->file, job->source )))
+            {
+                ERR("Failed to copy %s to %s (%u)\n", debugstr_w(job->source),
+                    debugstr_w(job->file->TargetPath), job->rc);
+                rc = ERROR_INSTALL_FAILURE;
+            }
+        }
+        if (job->rc == ERROR_SUCCESS && !msi_is_global_assembly( job->file->Component ))
+            job->file->state = msifs_installed;
+
+        list_remove( &job->entry );
+        free( job->source );
+        free( job );
+    }
+    queue->count = 0;
+    return rc;
+}
+
+static void free_copy_queue( struct copy_queue *queue, MSIPACKAGE *package )
+{
+    if (!queue) return;
+    finish_copy_queue( queue, package );
+    CloseThreadpoolCleanupGroup( queue->group );
+    DestroyThreadpoolEnvironment( &queue->env );
+    CloseThreadpool( queue->pool );
+    free( queue );
+}
+
 static UINT create_folder( MSIPACKAGE *package, const WCHAR *dir )
 {
     MSIFOLDER *folder;
@@ -527,7 +659,9 @@ static BOOL installfiles_cb(MSIPACKAGE *package, LPCWSTR filename, DWORD action,
     }
     else if (action == MSICABEXTRACT_FILEEXTRACTED)
     {
-        if (!msi_is_global_assembly( file->Component )) file->state = msifs_installed;
+        /* folders may be extracted in parallel, the cursor can point to another file */
+        if ((file = find_file( package, file->disk_id, filename )) && !msi_is_global_assembly( file->Component ))
+            file->state = msifs_installed;
     }
 
     return TRUE;
@@ -563,6 +697,7 @@ WCHAR *msi_resolve_file_source( MSIPACKAGE *package, MSIFILE *file )
  */
 UINT ACTION_InstallFiles(MSIPACKAGE *package)
 {
+    struct copy_queue *queue;
     MSIMEDIAINFO *mi;
     UINT rc = ERROR_SUCCESS;
     MSIFILE *file;
@@ -574,6 +709,7 @@ UINT ACTION_InstallFiles(MSIPACKAGE *package)
 
     schedule_install_files(package);
     mi = calloc(1, sizeof(MSIMEDIAINFO));
+    queue = create_copy_queue();
 
     LIST_FOR_EACH_ENTRY( file, &package->files, MSIFILE, entry )
     {
@@ -589,6 +725,11 @@ UINT ACTION_InstallFiles(MSIPACKAGE *package)
             goto done;
         }
 
+        /* pending copies may still read from the current media */
+        if (queue && queue->count && queue->disk_id != mi->disk_id &&
+            (rc = finish_copy_queue( queue, package )))
+            goto done;
+
         if (file->state != msifs_hashmatch &&
             file->state != msifs_skipped &&
             (file->state != msifs_present || !msi_get_property_int( package->db, L"Installed", 0 )) &&
@@ -611,6 +752,7 @@ UINT ACTION_InstallFiles(MSIPACKAGE *package)
             data.package = package;
             data.cb = installfiles_cb;
             data.user = &cursor;
+            data.pool = queue ? queue->pool : NULL;
 
             if (file->IsCompressed && !msi_cabextract(package, mi, &data))
             {
@@ -630,6 +772,9 @@ UINT ACTION_InstallFiles(MSIPACKAGE *package)
             {
                 create_folder(package, file->Component->Directory);
             }
+            if (queue_copy_file(queue, package, file, source, mi->disk_id))
+                continue;
+
             rc = copy_install_file(package, file, source);
             if (rc != ERROR_SUCCESS)
             {
@@ -650,7 +795,10 @@ UINT ACTION_InstallFiles(MSIPACKAGE *package)
         }
     }
 
+    rc = finish_copy_queue(queue, package);
+
 done:
+    free_copy_queue(queue, package);
     msi_free_media_info(mi);
     return rc;
 }
@@ -818,6 +966,7 @@ UINT ACTION_PatchFiles( MSIPACKAGE *package )
             data.package = package;
             data.cb      = patchfiles_cb;
             data.user    = &cursor;
+            data.pool    = NULL;
 
             if (!msi_cabextract( package, mi, &data ))
             {
@@ -172,13 +172,14 @@ static LONG CDECL cabinet_seek(INT_PTR hf, LONG dist, int seektype)
 
 struct package_disk
 {
-    MSIPACKAGE *package;
-    UINT        id;
+    MSIPACKAGE       *package;
+    UINT              id;
+    CRITICAL_SECTION *cs;
 };
 
 static struct package_disk package_disk;
 
-static INT_PTR CDECL cabinet_open_stream( char *pszFile, int oflag, int pmode )
+static IStream *open_cabinet_stream( void )
 {
     MSICABINETSTREAM *cab;
     IStream *stream;
@@ -186,7 +187,7 @@ static INT_PTR CDECL cabinet_open_stream( char *pszFile, int oflag, int pmode )
     if (!(cab = get_cabinet_stream( package_disk.package, package_disk.id )))
     {
         WARN("failed to get cabinet stream\n");
-        return -1;
+        return NULL;
     }
     if (cab->storage == package_disk.package->db->storage)
     {
@@ -194,7 +195,7 @@ static INT_PTR CDECL cabinet_open_stream( char *pszFile, int oflag, int pmode )
         if (r != ERROR_SUCCESS)
         {
             WARN("failed to get stream %u\n", r);
-            return -1;
+            return NULL;
         }
     }
     else /* patch storage */
@@ -205,17 +206,36 @@ static INT_PTR CDECL cabinet_open_stream( char *pszFile, int oflag, int pmode )
         if (!(encoded = encode_streamname( FALSE, cab->stream + 1 )))
         {
             WARN("failed to encode stream name\n");
-            return -1;
+            return NULL;
         }
         hr = IStorage_OpenStream( cab->storage, encoded, NULL, STGM_READ|STGM_SHARE_EXCLUSIVE, 0, &stream );
         free( encoded );
         if (FAILED(hr))
         {
             WARN( "failed to open stream %#lx\n", hr );
-            return -1;
+            return NULL;
         }
     }
-    return (INT_PTR)stream;
+    return stream;
+}
+
+static INT_PTR CDECL cabinet_open_stream( char *pszFile, int oflag, int pmode )
+{
+    IStream *stream, *clone;
+    HRESULT hr;
+
+    if (!package_disk.cs) return (stream = open_cabinet_stream()) ? (INT_PTR)stream : -1;
+
+    /* folders extracted in parallel each need their own seek pointer */
+    EnterCriticalSection( package_disk.cs );
+    if ((stream = open_cabinet_stream()))
+    {
+        hr = IStream_Clone( stream, &clone );
+        IStream_Release( stream );
+        stream = SUCCEEDED(hr) ? clone : NULL;
+    }
+    LeaveCriticalSection( package_disk.cs );
+    return stream ? (INT_PTR)stream : -1;
 }
 
 static UINT CDECL cabinet_read_stream( INT_PTR hf, void *pv, UINT cb )
@@ -224,7 +244,9 @@ static UINT CDECL cabinet_read_stream( INT_PTR hf, void *pv, UINT cb )
     DWORD read;
     HRESULT hr;
 
+    if (package_disk.cs) EnterCriticalSection( package_disk.cs );
     hr = IStream_Read( stm, pv, cb, &read );
+    if (package_disk.cs) LeaveCriticalSection( package_disk.cs );
     if (hr == S_OK || hr == S_FALSE)
         return read;
 
@@ -234,7 +256,10 @@ static UINT CDECL cabinet_read_stream( INT_PTR hf, void *pv, UINT cb )
 static int CDECL cabinet_close_stream( INT_PTR hf )
 {
     IStream *stm = (IStream *)hf;
+
+    if (package_disk.cs) EnterCriticalSection( package_disk.cs );
     IStream_Release( stm );
+    if (package_disk.cs) LeaveCriticalSection( package_disk.cs );
     return 0;
 }
 
@@ -246,7 +271,9 @@ static LONG CDECL cabinet_seek_stream( INT_PTR hf, LONG dist, int seektype )
     HRESULT hr;
 
     move.QuadPart = dist;
+    if (package_disk.cs) EnterCriticalSection( package_disk.cs );
     hr = IStream_Seek( stm, move, seektype, &newpos );
+    if (package_disk.cs) LeaveCriticalSection( package_disk.cs );
     if (SUCCEEDED(hr))
     {
         if (newpos.QuadPart <= MAXLONG) return newpos.QuadPart;
@@ -560,39 +587,164 @@ static INT_PTR CDECL cabinet_notify_stream( FDINOTIFICATIONTYPE fdint, PFDINOTIF
     }
 }
 
-static BOOL extract_cabinet( MSIPACKAGE* package, MSIMEDIAINFO *mi, LPVOID data )
+struct cabinet_source
+{
+    PFNOPEN      open;
+    PFNREAD      read;
+    PFNCLOSE     close;
+    PFNSEEK      seek;
+    PFNFDINOTIFY notify;
+    char        *name;
+    char        *path;
+};
+
+static BOOL copy_cabinet( const struct cabinet_source *source, PFNFDINOTIFY notify, void *data )
 {
-    LPSTR cabinet, cab_path = NULL;
     HFDI hfdi;
     ERF erf;
-    BOOL ret = FALSE;
-
-    TRACE("extracting %s disk id %u\n", debugstr_w(mi->cabinet), mi->disk_id);
+    BOOL ret;
 
-    hfdi = FDICreate( cabinet_alloc, cabinet_free, cabinet_open, cabinet_read,
-                      cabinet_write, cabinet_close, cabinet_seek, 0, &erf );
+    hfdi = FDICreate( cabinet_alloc, cabinet_free, source->open, source->read,
+                      cabinet_write, source->close, source->seek, 0, &erf );
     if (!hfdi)
     {
         ERR("FDICreate failed\n");
         return FALSE;
     }
 
-    cabinet = strdupWtoA( mi->cabinet );
-    if (!cabinet)
-        goto done;
-
-    cab_path = strdupWtoA( mi->sourcedir );
-    if (!cab_path)
-        goto done;
-
-    ret = FDICopy( hfdi, cabinet, cab_path, 0, cabinet_notify, NULL, data );
+    ret = FDICopy( hfdi, source->name, source->path, 0, notify, NULL, data );
     if (!ret)
         ERR("FDICopy failed\n");
 
-done:
     FDIDestroy( hfdi );
-    free( cabinet );
-    free( cab_path );
+    return ret;
+}
+
+/* returns the number of folders of a cabinet that doesn't span media */
+static USHORT get_cabinet_folders( const struct cabinet_source *source )
+{
+    FDICABINETINFO info;
+    char *filename;
+    INT_PTR hf;
+    HFDI hfdi;
+    ERF erf;
+    USHORT ret = 0;
+
+    if (!(filename = malloc( (source->path ? strlen( source->path ) : 0) + strlen( source->name ) + 1 )))
+        return 0;
+    strcpy( filename, source->path ? source->path : "" );
+    strcat( filename, source->name );
+
+    hfdi = FDICreate( cabinet_alloc, cabinet_free, source->open, source->read,
+                      cabinet_write, source->close, source->seek, 0, &erf );
+    if (hfdi && (hf = source->open( filename, _O_RDONLY, 0 )) != -1)
+    {
+        if (FDIIsCabinet( hfdi, hf, &info ) && !info.hasprev && !info.hasnext) ret = info.cFolders;
+        source->close( hf );
+    }
+    if (hfdi) FDIDestroy( hfdi );
+    free( filename );
+    return ret;
+}
+
+/*
+ * Folders are compressed independently, so each one can be decompressed
+ * with its own FDI context on the thread pool. Files outside the folder are
+ * skipped without being decompressed, and the notifications that create and
+ * close the files are serialized since they call back into the package.
+ */
+struct cabinet_folder_job
+{
+    MSICABDATA data;
+    const struct cabinet_source *source;
+    CRITICAL_SECTION *cs;
+    USHORT folder;
+    BOOL ret;
+};
+
+static INT_PTR CDECL cabinet_notify_folder( FDINOTIFICATIONTYPE fdint, PFDINOTIFICATION pfdin )
+{
+    struct cabinet_folder_job *job = pfdin->pv;
+    INT_PTR ret;
+
+    if (fdint == fdintCOPY_FILE && pfdin->iFolder != job->folder) return 0;
+    if (fdint != fdintCOPY_FILE && fdint != fdintCLOSE_FILE_INFO) return 0;
+
+    EnterCriticalSection( job->cs );
+    ret = job->source->notify( fdint, pfdin );
+    LeaveCriticalSection( job->cs );
+    return ret;
+}
+
+static void CALLBACK extract_folder_cb( TP_CALLBACK_INSTANCE *instance, void *context )
+{
+    struct cabinet_folder_job *job = context;
+
+    job->ret = copy_cabinet( job->source, cabinet_notify_folder, &job->data );
+}
+
+static BOOL extract_folders( const struct cabinet_source *source, USHORT count, MSICABDATA *data )
+{
+    struct cabinet_folder_job *jobs;
+    PTP_CLEANUP_GROUP group;
+    TP_CALLBACK_ENVIRON env;
+    CRITICAL_SECTION cs;
+    BOOL ret = TRUE;
+    USHORT i;
+
+    if (!(jobs = calloc( count, sizeof(*jobs) ))) return copy_cabinet( source, source->notify, data );
+    if (!(group = CreateThreadpoolCleanupGroup()))
+    {
+        free( jobs );
+        return copy_cabinet( source, source->notify, data );
+    }
+
+    InitializeCriticalSection( &cs );
+    InitializeThreadpoolEnvironment( &env );
+    SetThreadpoolCallbackPool( &env, data->pool );
+    SetThreadpoolCallbackCleanupGroup( &env, group, NULL );
+    package_disk.cs = &cs;
+
+    for (i = 0; i < count; i++)
+    {
+        jobs[i].data = *data;
+        jobs[i].data.curfile = NULL;
+        jobs[i].source = source;
+        jobs[i].cs = &cs;
+        jobs[i].folder = i;
+        if (!TrySubmitThreadpoolCallback( extract_folder_cb, &jobs[i], &env ))
+            extract_folder_cb( NULL, &jobs[i] );
+    }
+    CloseThreadpoolCleanupGroupMembers( group, FALSE, NULL );
+
+    package_disk.cs = NULL;
+    for (i = 0; i < count; i++) if (!jobs[i].ret) ret = FALSE;
+
+    CloseThreadpoolCleanupGroup( group );
+    DestroyThreadpoolEnvironment( &env );
+    DeleteCriticalSection( &cs );
+    free( jobs );
+    return ret;
+}
+
+static BOOL extract_cabinet_source( MSIMEDIAINFO *mi, const struct cabinet_source *source, BOOL parallel,
+                                    MSICABDATA *data )
+{
+    ULONGLONG start = GetTickCount64();
+    USHORT count = 0;
+    BOOL ret;
+
+    if (parallel && data->pool && (count = get_cabinet_folders( source )) > 1)
+    {
+        ret = extract_folders( source, count, data );
+        TRACE("extracted %u folders of %s in parallel in %I64u ms\n", count, debugstr_w(mi->cabinet),
+              GetTickCount64() - start);
+    }
+    else
+    {
+        ret = copy_cabinet( source, source->notify, data );
+        TRACE("extracted %s serially in %I64u ms\n", debugstr_w(mi->cabinet), GetTickCount64() - start);
+    }
 
     if (ret)
         mi->is_extracted = TRUE;
@@ -600,32 +752,36 @@ done:
     return ret;
 }
 
-static BOOL extract_cabinet_stream( MSIPACKAGE *package, MSIMEDIAINFO *mi, LPVOID data )
+static BOOL extract_cabinet( MSIPACKAGE* package, MSIMEDIAINFO *mi, LPVOID data )
 {
-    static char filename[] = {'<','S','T','R','E','A','M','>',0};
-    HFDI hfdi;
-    ERF erf;
+    struct cabinet_source source = { cabinet_open, cabinet_read, cabinet_close, cabinet_seek, cabinet_notify };
     BOOL ret = FALSE;
 
     TRACE("extracting %s disk id %u\n", debugstr_w(mi->cabinet), mi->disk_id);
 
-    hfdi = FDICreate( cabinet_alloc, cabinet_free, cabinet_open_stream, cabinet_read_stream,
-                      cabinet_write, cabinet_close_stream, cabinet_seek_stream, 0, &erf );
-    if (!hfdi)
-    {
-        ERR("FDICreate failed\n");
-        return FALSE;
-    }
+    if ((source.name = strdupWtoA( mi->cabinet )) && (source.path = strdupWtoA( mi->sourcedir )))
+        ret = extract_cabinet_source( mi, &source, TRUE, data );
+
+    free( source.name );
+    free( source.path );
+    return ret;
+}
+
+static BOOL extract_cabinet_stream( MSIPACKAGE *package, MSIMEDIAINFO *mi, LPVOID data )
+{
+    static char filename[] = {'<','S','T','R','E','A','M','>',0};
+    struct cabinet_source source = { cabinet_open_stream, cabinet_read_stream, cabinet_close_stream,
+                                     cabinet_seek_stream, cabinet_notify_stream, filename, NULL };
+    MSICABINETSTREAM *cab;
+
+    TRACE("extracting %s disk id %u\n", debugstr_w(mi->cabinet), mi->disk_id);
 
     package_disk.package = package;
     package_disk.id      = mi->disk_id;
 
-    ret = FDICopy( hfdi, filename, NULL, 0, cabinet_notify_stream, NULL, data );
-    if (!ret) ERR("FDICopy failed\n");
-
-    FDIDestroy( hfdi );
-    if (ret) mi->is_extracted = TRUE;
-    return ret;
+    /* patch streams are opened exclusively, so they can't be shared by several contexts */
+    cab = get_cabinet_stream( package, mi->disk_id );
+    return extract_cabinet_source( mi, &source, cab && cab->storage == package->db->storage, data );
 }
 
 /***********************************************************************
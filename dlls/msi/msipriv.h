@@ -226,7 +226,7 @@ typedef struct _column_info
     struct _column_info *next;
 } column_info;
 
-typedef const struct tagMSICOLUMNHASHENTRY *MSIITERHANDLE;
+typedef const struct column_hash_entry *MSIITERHANDLE;
 
 typedef struct tagMSIVIEWOPS
 {
@@ -347,6 +347,18 @@ typedef struct tagMSIVIEWOPS
      * drop - drops the table from the database
      */
     UINT (*drop)( struct tagMSIVIEW *view );
+
+    /*
+     * find_matching_rows - iterates through rows that match a value
+     *
+     * The value is compared to the stored value of the column, so string
+     *  columns are looked up by string ID, and integer columns by the biased
+     *  value returned by fetch_int.
+     * The handle is an input/output parameter that keeps track of the current
+     *  position in the iteration. It must be initialised to NULL before the
+     *  first call and continued to be passed in to subsequent calls.
+     */
+    UINT (*find_matching_rows)( struct tagMSIVIEW *view, UINT col, UINT val, UINT *row, MSIITERHANDLE *handle );
 } MSIVIEWOPS;
 
 struct tagMSIVIEW
@@ -1107,6 +1119,7 @@ typedef struct
     PMSICABEXTRACTCB cb;
     LPWSTR curfile;
     PVOID user;
+    PTP_POOL pool;
 } MSICABDATA;
 
 extern UINT ready_media(MSIPACKAGE *package, BOOL compressed, MSIMEDIAINFO *mi);
@@ -38,7 +38,7 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(msidb);
 
-#define MSITABLE_HASH_TABLE_SIZE 37
+#define MSITABLE_HASH_TABLE_MIN_SIZE 37
 
 struct column_hash_entry
 {
@@ -55,6 +55,7 @@ struct column_info
     UINT    type;
     UINT    offset;
     struct column_hash_entry **hash_table;
+    UINT    hash_size;
 };
 
 struct tagMSITABLE
@@ -1155,6 +1156,17 @@ static UINT TABLE_fetch_stream( struct tagMSIVIEW *view, UINT row, UINT col, ISt
     return r;
 }
 
+static void free_hash_tables( struct table_view *tv )
+{
+    UINT i;
+
+    for (i = 0; i < tv->num_cols; i++)
+    {
+        free( tv->columns[i].hash_table );
+        tv->columns[i].hash_table = NULL;
+    }
+}
+
 /* Set a table value, i.e. preadjusted integer or string ID. */
 static UINT table_set_bytes( struct table_view *tv, UINT row, UINT col, UINT val )
 {
@@ -1520,6 +1532,8 @@ static UINT table_create_new_row( struct tagMSIVIEW *view, UINT *num, BOOL tempo
         return ERROR_NOT_ENOUGH_MEMORY;
     }
 
+    free_hash_tables( tv );
+
     *data_ptr = p;
     (*data_ptr)[*row_count] = row;
 
@@ -1759,11 +1773,7 @@ static UINT TABLE_delete_row( struct tagMSIVIEW *view, UINT row )
     tv->table->row_count--;
 
     /* reset the hash tables */
-    for (i = 0; i < tv->num_cols; i++)
-    {
-        free(tv->columns[i].hash_table);
-        tv->columns[i].hash_table = NULL;
-    }
+    free_hash_tables( tv );
 
     for (i = row + 1; i < num_rows; i++)
     {
@@ -1947,6 +1957,7 @@ static UINT TABLE_remove_column(struct tagMSIVIEW *view, UINT number)
     if (tv->table->colinfo[number-1].type & MSITYPE_TEMPORARY)
     {
         UINT size = tv->table->colinfo[number-1].offset;
+        free( tv->table->colinfo[number-1].hash_table );
         tv->table->col_count--;
         tv->table->colinfo = realloc(tv->table->colinfo, sizeof(*tv->table->colinfo) * tv->table->col_count);
 
@@ -2165,6 +2176,79 @@ done:
     return r;
 }
 
+static UINT TABLE_find_matching_rows( struct tagMSIVIEW *view, UINT col,
+    UINT val, UINT *row, MSIITERHANDLE *handle )
+{
+    struct table_view *tv = (struct table_view *)view;
+    const struct column_hash_entry *entry;
+
+    TRACE("%p, %u, %u, %p\n", view, col, val, *handle);
+
+    if( !tv->table )
+        return ERROR_INVALID_PARAMETER;
+
+    if( (col==0) || (col > tv->num_cols) )
+        return ERROR_INVALID_PARAMETER;
+
+    if( !tv->columns[col-1].hash_table )
+    {
+        UINT i, hash_size;
+        UINT num_rows = tv->table->row_count;
+        struct column_hash_entry **hash_table;
+        struct column_hash_entry *new_entry;
+
+        if( tv->columns[col-1].offset >= tv->row_size )
+        {
+            ERR("Stuffed up %d >= %d\n", tv->columns[col-1].offset, tv->row_size );
+            ERR("%p %p\n", tv, tv->columns );
+            return ERROR_FUNCTION_FAILED;
+        }
+
+        hash_size = max( MSITABLE_HASH_TABLE_MIN_SIZE, num_rows | 1 );
+
+        /* allocate contiguous memory for the table and its entries so we
+         * don't have to do an expensive cleanup */
+        hash_table = calloc( 1, hash_size * sizeof(*hash_table) + num_rows * sizeof(*new_entry) );
+        if (!hash_table)
+            return ERROR_OUTOFMEMORY;
+
+        tv->columns[col-1].hash_table = hash_table;
+        tv->columns[col-1].hash_size = hash_size;
+
+        /* insert in reverse order, so that each bucket lists rows in ascending order */
+        new_entry = (struct column_hash_entry *)(hash_table + hash_size) + num_rows;
+        for (i = num_rows; i--;)
+        {
+            UINT row_value;
+
+            new_entry--;
+            if (view->ops->fetch_int( view, i, col, &row_value ) != ERROR_SUCCESS)
+                continue;
+
+            new_entry->value = row_value;
+            new_entry->row = i;
+            new_entry->next = hash_table[row_value % hash_size];
+            hash_table[row_value % hash_size] = new_entry;
+        }
+    }
+
+    if( !*handle )
+        entry = tv->columns[col-1].hash_table[val % tv->columns[col-1].hash_size];
+    else
+        entry = (*handle)->next;
+
+    while (entry && entry->value != val)
+        entry = entry->next;
+
+    *handle = entry;
+    if (!entry)
+        return ERROR_NO_MORE_ITEMS;
+
+    *row = entry->row;
+
+    return ERROR_SUCCESS;
+}
+
 static const MSIVIEWOPS table_ops =
 {
     TABLE_fetch_int,
@@ -2186,6 +2270,7 @@ static const MSIVIEWOPS table_ops =
     TABLE_add_column,
     NULL,
     TABLE_drop,
+    TABLE_find_matching_rows,
 };
 
 UINT TABLE_CreateView( MSIDATABASE *db, LPCWSTR name, MSIVIEW **view )
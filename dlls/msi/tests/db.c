@@ -3855,6 +3855,124 @@ static void test_join(void)
     DeleteFileA(msifile);
 }
 
+static UINT count_query_rows( MSIHANDLE hdb, const char *query )
+{
+    MSIHANDLE hview, hrec;
+    UINT r, count = 0;
+
+    r = MsiDatabaseOpenViewA( hdb, query, &hview );
+    ok( r == ERROR_SUCCESS, "MsiDatabaseOpenView failed: %u\n", r );
+    r = MsiViewExecute( hview, 0 );
+    ok( r == ERROR_SUCCESS, "MsiViewExecute failed: %u\n", r );
+    while (MsiViewFetch( hview, &hrec ) == ERROR_SUCCESS)
+    {
+        count++;
+        MsiCloseHandle( hrec );
+    }
+    MsiViewClose( hview );
+    MsiCloseHandle( hview );
+    return count;
+}
+
+static void test_join_large(void)
+{
+    MSIHANDLE hdb, hview, hrec;
+    char buf[32];
+    DWORD size;
+    UINT r, i, count;
+
+    hdb = create_db();
+    ok( hdb, "failed to create db\n" );
+
+    r = run_query( hdb, 0, "CREATE TABLE `Comp` (`Component` CHAR(72) NOT NULL, `Attr` SHORT, "
+                           "`Size` LONG PRIMARY KEY `Component`)" );
+    ok( r == ERROR_SUCCESS, "cannot create table: %u\n", r );
+    r = run_query( hdb, 0, "CREATE TABLE `File` (`File` CHAR(72) NOT NULL, `Component_` CHAR(72), "
+                           "`Seq` SHORT PRIMARY KEY `File`)" );
+    ok( r == ERROR_SUCCESS, "cannot create table: %u\n", r );
+
+    r = MsiDatabaseOpenViewA( hdb, "INSERT INTO `Comp` (`Component`, `Attr`, `Size`) VALUES (?, ?, ?)", &hview );
+    ok( r == ERROR_SUCCESS, "MsiDatabaseOpenView failed: %u\n", r );
+    hrec = MsiCreateRecord( 3 );
+    for (i = 0; i < 200; i++)
+    {
+        sprintf( buf, "c%u", i );
+        MsiRecordSetStringA( hrec, 1, buf );
+        MsiRecordSetInteger( hrec, 2, i % 4 );
+        MsiRecordSetInteger( hrec, 3, i * 100000 );
+        r = MsiViewExecute( hview, hrec );
+        ok( r == ERROR_SUCCESS, "MsiViewExecute failed: %u\n", r );
+    }
+    MsiCloseHandle( hrec );
+    MsiViewClose( hview );
+    MsiCloseHandle( hview );
+
+    r = MsiDatabaseOpenViewA( hdb, "INSERT INTO `File` (`File`, `Component_`, `Seq`) VALUES (?, ?, ?)", &hview );
+    ok( r == ERROR_SUCCESS, "MsiDatabaseOpenView failed: %u\n", r );
+    hrec = MsiCreateRecord( 3 );
+    for (i = 0; i < 605; i++)
+    {
+        sprintf( buf, "f%u", i );
+        MsiRecordSetStringA( hrec, 1, buf );
+        if (i < 600) sprintf( buf, "c%u", i % 200 );
+        else strcpy( buf, "notacomponent" );
+        MsiRecordSetStringA( hrec, 2, buf );
+        MsiRecordSetInteger( hrec, 3, i );
+        r = MsiViewExecute( hview, hrec );
+        ok( r == ERROR_SUCCESS, "MsiViewExecute failed: %u\n", r );
+    }
+    MsiCloseHandle( hrec );
+    MsiViewClose( hview );
+    MsiCloseHandle( hview );
+
+    count = count_query_rows( hdb, "SELECT `File` FROM `File`, `Comp` WHERE `Component_` = `Component`" );
+    ok( count == 600, "got %u rows\n", count );
+    count = count_query_rows( hdb, "SELECT `File` FROM `File`, `Comp` WHERE `Component_` = `Component` AND `Attr` = 3" );
+    ok( count == 150, "got %u rows\n", count );
+    count = count_query_rows( hdb, "SELECT `File` FROM `Comp`, `File` WHERE `Attr` = 3 AND `Component` = `Component_`" );
+    ok( count == 150, "got %u rows\n", count );
+    count = count_query_rows( hdb, "SELECT `File` FROM `File`, `Comp` WHERE `Component_` = `Component` AND `Attr` = 3 "
+                                   "AND `Seq` < 200" );
+    ok( count == 50, "got %u rows\n", count );
+    count = count_query_rows( hdb, "SELECT `File` FROM `File` WHERE `Component_` = 'c7'" );
+    ok( count == 3, "got %u rows\n", count );
+    count = count_query_rows( hdb, "SELECT `File` FROM `File` WHERE `Component_` = 'nosuchcomponent'" );
+    ok( count == 0, "got %u rows\n", count );
+    count = count_query_rows( hdb, "SELECT `Component` FROM `Comp` WHERE `Attr` = 70000" );
+    ok( count == 0, "got %u rows\n", count );
+    count = count_query_rows( hdb, "SELECT `Component` FROM `Comp` WHERE `Attr` = 2 OR `Attr` = 1" );
+    ok( count == 100, "got %u rows\n", count );
+
+    r = do_query( hdb, "SELECT `Component` FROM `Comp` WHERE `Size` = 500000", &hrec );
+    ok( r == ERROR_SUCCESS, "query failed: %u\n", r );
+    size = sizeof(buf);
+    r = MsiRecordGetStringA( hrec, 1, buf, &size );
+    ok( r == ERROR_SUCCESS, "MsiRecordGetString failed: %u\n", r );
+    ok( !strcmp( buf, "c5" ), "got %s\n", buf );
+    MsiCloseHandle( hrec );
+
+    /* indexes are updated when the tables change */
+    r = run_query( hdb, 0, "DELETE FROM `Comp` WHERE `Component` = 'c3'" );
+    ok( r == ERROR_SUCCESS, "cannot delete row: %u\n", r );
+    count = count_query_rows( hdb, "SELECT `File` FROM `File`, `Comp` WHERE `Component_` = `Component` AND `Attr` = 3" );
+    ok( count == 147, "got %u rows\n", count );
+
+    r = run_query( hdb, 0, "INSERT INTO `Comp` (`Component`, `Attr`, `Size`) VALUES ('notacomponent', 3, 0)" );
+    ok( r == ERROR_SUCCESS, "cannot insert row: %u\n", r );
+    count = count_query_rows( hdb, "SELECT `File` FROM `File`, `Comp` WHERE `Component_` = `Component` AND `Attr` = 3" );
+    ok( count == 152, "got %u rows\n", count );
+
+    r = run_query( hdb, 0, "UPDATE `File` SET `Component_` = 'c3' WHERE `Component_` = 'c7'" );
+    ok( r == ERROR_SUCCESS, "cannot update rows: %u\n", r );
+    count = count_query_rows( hdb, "SELECT `File` FROM `File` WHERE `Component_` = 'c7'" );
+    ok( count == 0, "got %u rows\n", count );
+    count = count_query_rows( hdb, "SELECT `File` FROM `File` WHERE `Component_` = 'c3'" );
+    ok( count == 6, "got %u rows\n", count );
+
+    MsiCloseHandle( hdb );
+    DeleteFileA( msifile );
+}
+
 static void test_temporary_table(void)
 {
     MSICONDITION cond;
@@ -9427,6 +9545,7 @@ START_TEST(db)
     test_handle_limit();
     test_try_transform();
     test_join();
+    test_join_large();
     test_temporary_table();
     test_alter();
     test_integers();
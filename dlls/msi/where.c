@@ -647,38 +647,179 @@ static UINT WHERE_evaluate( MSIWHEREVIEW *wv, const UINT rows[],
     return ERROR_SUCCESS;
 }
 
+static BOOL is_table_column( const struct expr *expr, const struct join_table *table )
+{
+    return (expr->type == EXPR_COL_NUMBER || expr->type == EXPR_COL_NUMBER32 ||
+            expr->type == EXPR_COL_NUMBER_STRING) && expr->u.column.parsed.table == table;
+}
+
+/* fetches the stored value of a column of an already joined table */
+static BOOL get_bound_column_value( const struct expr *expr, const struct expr *column, const UINT rows[], UINT *key )
+{
+    struct join_table *table;
+
+    if (expr->type != column->type)
+        return FALSE;
+
+    table = expr->u.column.parsed.table;
+    if (rows[table->table_index] == INVALID_ROW_INDEX)
+        return FALSE;
+
+    return table->view->ops->fetch_int( table->view, rows[table->table_index],
+                                        expr->u.column.parsed.column, key ) == ERROR_SUCCESS;
+}
+
+static BOOL get_key_value( MSIWHEREVIEW *wv, const struct expr *column, const struct expr *expr,
+                           const UINT rows[], UINT *key, BOOL *empty )
+{
+    INT ival;
+
+    switch (expr->type)
+    {
+    case EXPR_UVAL:
+        /* stored value is biased, see WHERE_evaluate */
+        if (column->type == EXPR_COL_NUMBER32)
+        {
+            *key = expr->u.uval + 0x80000000;
+            return TRUE;
+        }
+        if (column->type != EXPR_COL_NUMBER)
+            return FALSE;
+        ival = (INT)expr->u.uval + 0x8000;
+        if (ival < 0 || ival > 0xffff)
+            *empty = TRUE;
+        *key = ival;
+        return TRUE;
+
+    case EXPR_SVAL:
+        /* empty strings are equal to NULL strings, which are not in the string table */
+        if (column->type != EXPR_COL_NUMBER_STRING || !*expr->u.sval)
+            return FALSE;
+        if (msi_string2id( wv->db->strings, expr->u.sval, -1, key ) != ERROR_SUCCESS)
+            *empty = TRUE;
+        return TRUE;
+
+    case EXPR_COL_NUMBER:
+    case EXPR_COL_NUMBER32:
+    case EXPR_COL_NUMBER_STRING:
+        if (!get_bound_column_value( expr, column, rows, key ))
+            return FALSE;
+        return column->type != EXPR_COL_NUMBER_STRING || *key;
+
+    default:
+        return FALSE;
+    }
+}
+
+/*
+ * Looks for an equality comparison in the AND-ed part of the condition, which compares a column
+ * of the table to a constant or to a column of a table which has already been joined. Rows that
+ * don't match it can't match the condition, so only the rows found in the column index need
+ * to be checked.
+ */
+static BOOL find_index_key( MSIWHEREVIEW *wv, const struct expr *cond, const struct join_table *table,
+                            const UINT rows[], UINT *col, UINT *key, BOOL *empty )
+{
+    const struct expr *column, *other;
+
+    if (cond->type != EXPR_COMPLEX && cond->type != EXPR_STRCMP)
+        return FALSE;
+
+    if (cond->type == EXPR_COMPLEX && cond->u.expr.op == OP_AND)
+        return find_index_key( wv, cond->u.expr.left, table, rows, col, key, empty ) ||
+               find_index_key( wv, cond->u.expr.right, table, rows, col, key, empty );
+
+    if (cond->u.expr.op != OP_EQ)
+        return FALSE;
+
+    if (is_table_column( cond->u.expr.left, table ))
+    {
+        column = cond->u.expr.left;
+        other = cond->u.expr.right;
+    }
+    else if (is_table_column( cond->u.expr.right, table ))
+    {
+        column = cond->u.expr.right;
+        other = cond->u.expr.left;
+    }
+    else return FALSE;
+
+    *empty = FALSE;
+    if (!get_key_value( wv, column, other, rows, key, empty ))
+        return FALSE;
+
+    *col = column->u.column.parsed.column;
+    return TRUE;
+}
+
+static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, struct join_table **tables,
+                             UINT table_rows[] );
+
+static UINT check_row( MSIWHEREVIEW *wv, MSIRECORD *record, struct join_table **tables,
+                       UINT table_rows[], BOOL *stop )
+{
+    UINT r;
+    INT val = 0;
+
+    *stop = TRUE;
+    wv->rec_index = 0;
+    r = WHERE_evaluate( wv, table_rows, wv->cond, &val, record );
+    if (r != ERROR_SUCCESS && r != ERROR_CONTINUE)
+        return r;
+    if (val)
+    {
+        if (*(tables + 1))
+        {
+            r = check_condition(wv, record, tables + 1, table_rows);
+            if (r != ERROR_SUCCESS)
+                return r;
+        }
+        else
+        {
+            if (r != ERROR_SUCCESS)
+                return r;
+            add_row (wv, table_rows);
+        }
+    }
+    *stop = FALSE;
+    return r;
+}
+
 static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, struct join_table **tables,
                              UINT table_rows[] )
 {
-    UINT r = ERROR_FUNCTION_FAILED;
-    INT val;
+    struct join_table *table = *tables;
+    UINT r = ERROR_FUNCTION_FAILED, col, key, row;
+    MSIITERHANDLE handle = NULL;
+    BOOL empty, stop;
 
-    for (table_rows[(*tables)->table_index] = 0;
-         table_rows[(*tables)->table_index] < (*tables)->row_count;
-         table_rows[(*tables)->table_index]++)
+    if (wv->cond && table->view->ops->find_matching_rows &&
+        find_index_key( wv, wv->cond, table, table_rows, &col, &key, &empty ))
     {
-        val = 0;
-        wv->rec_index = 0;
-        r = WHERE_evaluate( wv, table_rows, wv->cond, &val, record );
-        if (r != ERROR_SUCCESS && r != ERROR_CONTINUE)
-            break;
-        if (val)
+        TRACE("using index of column %u of table %u, key %#x\n", col, table->table_index, key);
+
+        r = ERROR_SUCCESS;
+        while (!empty && table->view->ops->find_matching_rows( table->view, col, key, &row, &handle ) == ERROR_SUCCESS)
         {
-            if (*(tables + 1))
-            {
-                r = check_condition(wv, record, tables + 1, table_rows);
-                if (r != ERROR_SUCCESS)
-                    break;
-            }
-            else
-            {
-                if (r != ERROR_SUCCESS)
-                    break;
-                add_row (wv, table_rows);
-            }
+            table_rows[table->table_index] = row;
+            r = check_row( wv, record, tables, table_rows, &stop );
+            if (stop)
+                break;
+            r = ERROR_SUCCESS;
+        }
+    }
+    else
+    {
+        for (table_rows[table->table_index] = 0;
+             table_rows[table->table_index] < table->row_count;
+             table_rows[table->table_index]++)
+        {
+            r = check_row( wv, record, tables, table_rows, &stop );
+            if (stop)
+                break;
         }
     }
-    table_rows[(*tables)->table_index] = INVALID_ROW_INDEX;
+    table_rows[table->table_index] = INVALID_ROW_INDEX;
     return r;
 }
 
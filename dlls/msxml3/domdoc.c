@@ -83,8 +83,32 @@ typedef struct {
     LONG selectNsStr_len;
     BOOL XPath;
     IUri *uri;
+    struct list xpath_cache;
+    unsigned int xpath_cache_count;
+    LONG xpath_cache_gen;
 } domdoc_properties;
 
+/* Compiled selectNodes() queries, most recently used first. Entries are
+ * taken out of the list while they are evaluated. */
+#define XPATH_CACHE_SIZE 16
+
+struct xpath_cache_entry
+{
+    struct list entry;
+    xmlChar *query;
+    BOOL xpath;
+    xmlXPathCompExprPtr comp;
+};
+
+static CRITICAL_SECTION xpath_cache_cs;
+static CRITICAL_SECTION_DEBUG xpath_cache_cs_dbg =
+{
+    0, 0, &xpath_cache_cs,
+    { &xpath_cache_cs_dbg.ProcessLocksList, &xpath_cache_cs_dbg.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": xpath_cache") }
+};
+static CRITICAL_SECTION xpath_cache_cs = { &xpath_cache_cs_dbg, -1, 0, 0, 0, 0 };
+
 typedef struct ConnectionPoint ConnectionPoint;
 typedef struct domdoc domdoc;
 
@@ -256,6 +280,98 @@ int registerNamespaces(xmlXPathContextPtr ctxt)
     return n;
 }
 
+static void free_xpath_cache_entry(struct xpath_cache_entry *entry)
+{
+    xmlXPathFreeCompExpr(entry->comp);
+    xmlFree(entry->query);
+    heap_free(entry);
+}
+
+static void clear_xpath_cache(domdoc_properties *properties)
+{
+    struct xpath_cache_entry *entry, *entry2;
+    struct list entries;
+
+    list_init(&entries);
+    EnterCriticalSection(&xpath_cache_cs);
+    list_move_tail(&entries, &properties->xpath_cache);
+    properties->xpath_cache_count = 0;
+    properties->xpath_cache_gen++;
+    LeaveCriticalSection(&xpath_cache_cs);
+
+    LIST_FOR_EACH_ENTRY_SAFE(entry, entry2, &entries, struct xpath_cache_entry, entry)
+        free_xpath_cache_entry(entry);
+}
+
+static struct xpath_cache_entry *find_xpath_cache_entry(domdoc_properties *properties, const xmlChar *query,
+        BOOL xpath)
+{
+    struct xpath_cache_entry *entry;
+
+    LIST_FOR_EACH_ENTRY(entry, &properties->xpath_cache, struct xpath_cache_entry, entry)
+    {
+        if (entry->xpath == xpath && xmlStrEqual(entry->query, query))
+            return entry;
+    }
+    return NULL;
+}
+
+/* Takes a compiled query out of the cache, the caller gives it back with
+ * xmldoc_cache_xpath() once it is done evaluating it. */
+xmlXPathCompExprPtr xmldoc_lookup_xpath(xmlDocPtr doc, const xmlChar *query, BOOL xpath, LONG *gen)
+{
+    domdoc_properties *properties = properties_from_xmlDocPtr(doc);
+    struct xpath_cache_entry *entry;
+    xmlXPathCompExprPtr comp = NULL;
+
+    EnterCriticalSection(&xpath_cache_cs);
+    *gen = properties->xpath_cache_gen;
+    if ((entry = find_xpath_cache_entry(properties, query, xpath)))
+    {
+        list_remove(&entry->entry);
+        properties->xpath_cache_count--;
+        comp = entry->comp;
+        entry->comp = NULL;
+    }
+    LeaveCriticalSection(&xpath_cache_cs);
+
+    if (entry) free_xpath_cache_entry(entry);
+    return comp;
+}
+
+void xmldoc_cache_xpath(xmlDocPtr doc, const xmlChar *query, BOOL xpath, xmlXPathCompExprPtr comp, LONG gen)
+{
+    domdoc_properties *properties = properties_from_xmlDocPtr(doc);
+    struct xpath_cache_entry *entry, *evicted = NULL;
+
+    if (!(entry = heap_alloc(sizeof(*entry))))
+    {
+        xmlXPathFreeCompExpr(comp);
+        return;
+    }
+    entry->query = xmlStrdup(query);
+    entry->xpath = xpath;
+    entry->comp = comp;
+
+    EnterCriticalSection(&xpath_cache_cs);
+    /* namespaces changed or another thread cached the same query meanwhile */
+    if (entry->query && gen == properties->xpath_cache_gen && !find_xpath_cache_entry(properties, query, xpath))
+    {
+        list_add_head(&properties->xpath_cache, &entry->entry);
+        entry = NULL;
+        if (++properties->xpath_cache_count > XPATH_CACHE_SIZE)
+        {
+            evicted = LIST_ENTRY(list_tail(&properties->xpath_cache), struct xpath_cache_entry, entry);
+            list_remove(&evicted->entry);
+            properties->xpath_cache_count--;
+        }
+    }
+    LeaveCriticalSection(&xpath_cache_cs);
+
+    if (entry) free_xpath_cache_entry(entry);
+    if (evicted) free_xpath_cache_entry(evicted);
+}
+
 static inline void clear_selectNsList(struct list* pNsList)
 {
     select_ns_entry *ns, *ns2;
@@ -291,6 +407,9 @@ static domdoc_properties *create_properties(MSXML_VERSION version)
     properties->schemaCache = NULL;
     properties->selectNsStr = heap_alloc_zero(sizeof(xmlChar));
     properties->selectNsStr_len = 0;
+    list_init(&properties->xpath_cache);
+    properties->xpath_cache_count = 0;
+    properties->xpath_cache_gen = 0;
 
     /* properties that are dependent on object versions */
     properties->version = version;
@@ -337,6 +456,10 @@ static domdoc_properties* copy_properties(domdoc_properties const* properties)
         pcopy->uri = properties->uri;
         if (pcopy->uri)
             IUri_AddRef(pcopy->uri);
+
+        list_init(&pcopy->xpath_cache);
+        pcopy->xpath_cache_count = 0;
+        pcopy->xpath_cache_gen = 0;
     }
 
     return pcopy;
@@ -371,6 +494,7 @@ static void properties_release(domdoc_properties *properties)
         if (properties->schemaCache)
             IXMLDOMSchemaCollection2_Release(properties->schemaCache);
         clear_selectNsList(&properties->selectNsList);
+        clear_xpath_cache(properties);
         heap_free((xmlChar*)properties->selectNsStr);
         if (properties->uri)
             IUri_Release(properties->uri);
@@ -3045,6 +3169,7 @@ static HRESULT WINAPI domdoc_setProperty(
             bstr = V_BSTR(&value);
 
         hr = S_OK;
+        clear_xpath_cache(This->properties);
         if (lstrcmpiW(bstr, PropValueXPathW) == 0)
             This->properties->XPath = TRUE;
         else if (lstrcmpiW(bstr, PropValueXSLPatternW) == 0)
@@ -3077,6 +3202,7 @@ static HRESULT WINAPI domdoc_setProperty(
 
         pNsList = &(This->properties->selectNsList);
         clear_selectNsList(pNsList);
+        clear_xpath_cache(This->properties);
         heap_free(nsStr);
         nsStr = xmlchar_from_wchar(bstr);
 
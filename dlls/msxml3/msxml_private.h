@@ -184,6 +184,9 @@ extern void wineXmlCallbackError(char const* caller, xmlErrorPtr err);
 extern BOOL is_preserving_whitespace(xmlNodePtr node);
 extern BOOL is_xpathmode(const xmlDocPtr doc);
 extern void set_xpathmode(xmlDocPtr doc, BOOL xpath);
+extern struct _xmlXPathCompExpr *xmldoc_lookup_xpath(xmlDocPtr doc, const xmlChar *query, BOOL xpath, LONG *gen);
+extern void xmldoc_cache_xpath(xmlDocPtr doc, const xmlChar *query, BOOL xpath,
+                               struct _xmlXPathCompExpr *comp, LONG gen);
 
 extern void init_xmlnode(xmlnode*,xmlNodePtr,IXMLDOMNode*,dispex_static_data_t*);
 extern void destroy_xmlnode(xmlnode*);
@@ -765,7 +765,10 @@ HRESULT create_selection(xmlNodePtr node, xmlChar* query, IXMLDOMNodeList **out)
 {
     domselection *This = heap_alloc(sizeof(domselection));
     xmlXPathContextPtr ctxt = xmlXPathNewContext(node->doc);
+    xmlXPathCompExprPtr comp;
+    BOOL xpath;
     HRESULT hr;
+    LONG gen;
 
     TRACE("(%p, %s, %p)\n", node, debugstr_a((char const*)query), out);
 
@@ -789,15 +792,16 @@ HRESULT create_selection(xmlNodePtr node, xmlChar* query, IXMLDOMNodeList **out)
     ctxt->node = node;
     registerNamespaces(ctxt);
 
-    if (is_xpathmode(This->node->doc))
+    xpath = is_xpathmode(This->node->doc);
+    comp = xmldoc_lookup_xpath(This->node->doc, query, xpath, &gen);
+
+    if (xpath)
     {
         xmlXPathRegisterAllFunctions(ctxt);
-        This->result = xmlXPathEvalExpression(query, ctxt);
+        if (!comp) comp = xmlXPathCtxtCompile(ctxt, query);
     }
     else
     {
-        xmlChar* pattern_query = XSLPattern_to_XPath(ctxt, query);
-
         xmlXPathRegisterFunc(ctxt, (xmlChar const*)"not", xmlXPathNotFunction);
         xmlXPathRegisterFunc(ctxt, (xmlChar const*)"boolean", xmlXPathBooleanFunction);
 
@@ -812,9 +816,21 @@ HRESULT create_selection(xmlNodePtr node, xmlChar* query, IXMLDOMNodeList **out)
         xmlXPathRegisterFunc(ctxt, (xmlChar const*)"OP_IGt", XSLPattern_OP_IGt);
         xmlXPathRegisterFunc(ctxt, (xmlChar const*)"OP_IGEq", XSLPattern_OP_IGEq);
 
-        This->result = xmlXPathEvalExpression(pattern_query, ctxt);
-        xmlFree(pattern_query);
+        if (!comp)
+        {
+            xmlChar* pattern_query = XSLPattern_to_XPath(ctxt, query);
+            comp = xmlXPathCtxtCompile(ctxt, pattern_query);
+            xmlFree(pattern_query);
+        }
+    }
+
+    if (comp)
+    {
+        This->result = xmlXPathCompiledEval(comp, ctxt);
+        xmldoc_cache_xpath(This->node->doc, query, xpath, comp, gen);
     }
+    else
+        This->result = NULL;
 
     if (!This->result || This->result->type != XPATH_NODESET)
     {
@@ -5176,6 +5176,21 @@ if (0)
     ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
     expect_list_and_release(list, "E6.E1.E5.E1.E2.D1 E6.E2.E5.E1.E2.D1");
 
+    /* rebinding the prefix applies to queries that were already run */
+    hr = IXMLDOMDocument2_setProperty(doc, _bstr_("SelectionNamespaces"),
+        _variantbstr_("xmlns:test='urn:nonexistent'"));
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    hr = IXMLDOMDocument2_selectNodes(doc, _bstr_("root//test:c"), &list);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    expect_list_and_release(list, "");
+
+    hr = IXMLDOMDocument2_setProperty(doc, _bstr_("SelectionNamespaces"),
+        _variantbstr_("xmlns:test='urn:uuid:86B2F87F-ACB6-45cd-8B77-9BDB92A01A29'"));
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    hr = IXMLDOMDocument2_selectNodes(doc, _bstr_("root//test:c"), &list);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    expect_list_and_release(list, "E3.E3.E2.D1 E3.E4.E2.D1");
+
     /* SelectionNamespaces syntax error - the namespaces doesn't work anymore but the value is stored */
     hr = IXMLDOMDocument2_setProperty(doc, _bstr_("SelectionNamespaces"),
         _variantbstr_("xmlns:test='urn:uuid:86B2F87F-ACB6-45cd-8B77-9BDB92A01A29' xmlns:foo=###"));
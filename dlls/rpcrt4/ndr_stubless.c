@@ -519,7 +519,8 @@ void client_do_args( PMIDL_STUB_MESSAGE pStubMsg, PFORMAT_STRING pFormat, enum s
         case STUBLESS_CALCSIZE:
             if (params[i].attr.IsSimpleRef && !*(unsigned char **)pArg)
                 RpcRaiseException(RPC_X_NULL_REF_POINTER);
-            if (params[i].attr.IsIn) call_buffer_sizer(pStubMsg, pArg, &params[i]);
+            if (params[i].attr.IsIn && params[i].attr.MustSize)
+                call_buffer_sizer(pStubMsg, pArg, &params[i]);
             break;
         case STUBLESS_MARSHAL:
             if (params[i].attr.IsIn) call_marshaller(pStubMsg, pArg, &params[i]);
@@ -609,6 +610,8 @@ PFORMAT_STRING convert_old_args( PMIDL_STUB_MESSAGE pStubMsg, PFORMAT_STRING pFo
 
         args[i].stack_offset = stack_offset;
         memset( &args[i].attr, 0, sizeof(args[i].attr) );
+        /* the old format has no constant buffer size, everything must be sized */
+        args[i].attr.MustSize = 1;
 
         switch (param->param_direction)
         {
@@ -705,7 +708,8 @@ static void CALLBACK ndr_client_call_finally(BOOL normal, void *arg)
 static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORMAT_STRING format,
         const PFORMAT_STRING handle_format, void **stack_top, void **fpu_stack, MIDL_STUB_MESSAGE *stub_msg,
         unsigned short procedure_number, unsigned short stack_size, unsigned int number_of_params,
-        INTERPRETER_OPT_FLAGS Oif_flags, INTERPRETER_OPT_FLAGS2 ext_flags, const NDR_PROC_HEADER *proc_header )
+        unsigned short client_buffer_size, INTERPRETER_OPT_FLAGS Oif_flags, INTERPRETER_OPT_FLAGS2 ext_flags,
+        const NDR_PROC_HEADER *proc_header )
 {
     struct ndr_client_call_ctx finally_ctx;
     RPC_MESSAGE rpc_msg;
@@ -750,7 +754,9 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
             if (!hbinding) return 0;
         }
 
-        stub_msg->BufferLength = 0;
+        /* fixed size parameters are accounted for in the constant buffer
+         * size, only those flagged as MustSize are sized at run time */
+        stub_msg->BufferLength = client_buffer_size;
 
         /* store the RPC flags away */
         if (proc_header->Oi_flags & Oi_HAS_RPCFLAGS)
@@ -860,6 +866,8 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
     unsigned short stack_size;
     /* number of parameters. optional for client to give it to us */
     unsigned int number_of_params;
+    /* pre-computed buffer size of the fixed size [in] parameters */
+    unsigned short client_buffer_size = 0;
     /* cache of Oif_flags from v2 procedure header */
     INTERPRETER_OPT_FLAGS Oif_flags = { 0 };
     /* cache of extension flags from NDR_PROC_HEADER_EXTS */
@@ -906,6 +914,7 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
 
         Oif_flags = pOIFHeader->Oi2Flags;
         number_of_params = pOIFHeader->number_of_params;
+        client_buffer_size = pOIFHeader->constant_client_buffer_size;
 
         pFormat += sizeof(NDR_PROC_PARTIAL_OIF_HEADER);
 
@@ -944,7 +953,7 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
         {
             RetVal = do_ndr_client_call(pStubDesc, pFormat, pHandleFormat,
                     stack_top, fpu_stack, &stubMsg, procedure_number, stack_size,
-                    number_of_params, Oif_flags, ext_flags, pProcHeader);
+                    number_of_params, client_buffer_size, Oif_flags, ext_flags, pProcHeader);
         }
         __EXCEPT_ALL
         {
@@ -962,7 +971,7 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
         {
             RetVal = do_ndr_client_call(pStubDesc, pFormat, pHandleFormat,
                     stack_top, fpu_stack, &stubMsg, procedure_number, stack_size,
-                    number_of_params, Oif_flags, ext_flags, pProcHeader);
+                    number_of_params, client_buffer_size, Oif_flags, ext_flags, pProcHeader);
         }
         __EXCEPT_ALL
         {
@@ -995,7 +1004,7 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
     {
         RetVal = do_ndr_client_call(pStubDesc, pFormat, pHandleFormat,
                 stack_top, fpu_stack, &stubMsg, procedure_number, stack_size,
-                number_of_params, Oif_flags, ext_flags, pProcHeader);
+                number_of_params, client_buffer_size, Oif_flags, ext_flags, pProcHeader);
     }
 
     TRACE("RetVal = 0x%Ix\n", RetVal);
@@ -1285,7 +1294,7 @@ static LONG_PTR *stub_do_args(MIDL_STUB_MESSAGE *pStubMsg,
                 call_unmarshaller(pStubMsg, &pArg, &params[i], 0);
             break;
         case STUBLESS_CALCSIZE:
-            if (params[i].attr.IsOut || params[i].attr.IsReturn)
+            if ((params[i].attr.IsOut || params[i].attr.IsReturn) && params[i].attr.MustSize)
                 call_buffer_sizer(pStubMsg, pArg, &params[i]);
             break;
         default:
@@ -1321,6 +1330,8 @@ LONG WINAPI NdrStubCall2(
     unsigned short stack_size;
     /* number of parameters. optional for client to give it to us */
     unsigned int number_of_params;
+    /* pre-computed buffer size of the fixed size [out] parameters */
+    unsigned short server_buffer_size = 0;
     /* cache of Oif_flags from v2 procedure header */
     INTERPRETER_OPT_FLAGS Oif_flags = { 0 };
     /* cache of extension flags from NDR_PROC_HEADER_EXTS */
@@ -1430,6 +1441,7 @@ LONG WINAPI NdrStubCall2(
 
         Oif_flags = pOIFHeader->Oi2Flags;
         number_of_params = pOIFHeader->number_of_params;
+        server_buffer_size = pOIFHeader->constant_server_buffer_size;
 
         pFormat += sizeof(NDR_PROC_PARTIAL_OIF_HEADER);
 
@@ -1505,7 +1517,7 @@ LONG WINAPI NdrStubCall2(
             }
 
             stubMsg.Buffer = NULL;
-            stubMsg.BufferLength = 0;
+            stubMsg.BufferLength = server_buffer_size;
 
             break;
         case STUBLESS_GETBUFFER:
@@ -1681,6 +1693,7 @@ static void do_ndr_async_client_call( const MIDL_STUB_DESC *pStubDesc, PFORMAT_S
 
         Oif_flags = pOIFHeader->Oi2Flags;
         async_call_data->number_of_params = pOIFHeader->number_of_params;
+        async_call_data->buffer_size = pOIFHeader->constant_client_buffer_size;
 
         pFormat += sizeof(NDR_PROC_PARTIAL_OIF_HEADER);
 
@@ -1700,11 +1713,12 @@ static void do_ndr_async_client_call( const MIDL_STUB_DESC *pStubDesc, PFORMAT_S
                                     pProcHeader->Oi_flags & Oi_OBJECT_PROC,
                                     async_call_data->NdrCorrCache, sizeof(async_call_data->NdrCorrCache),
                                     &async_call_data->number_of_params );
+        async_call_data->buffer_size = 0;
     }
 
     async_call_data->pParamFormat = pFormat;
 
-    pStubMsg->BufferLength = 0;
+    pStubMsg->BufferLength = async_call_data->buffer_size;
 
     /* store the RPC flags away */
     if (pProcHeader->Oi_flags & Oi_HAS_RPCFLAGS)
@@ -2067,6 +2081,7 @@ void RPC_ENTRY NdrAsyncServerCall(PRPC_MESSAGE pRpcMsg)
 
         Oif_flags = pOIFHeader->Oi2Flags;
         async_call_data->number_of_params = pOIFHeader->number_of_params;
+        async_call_data->buffer_size = pOIFHeader->constant_server_buffer_size;
 
         pFormat += sizeof(NDR_PROC_PARTIAL_OIF_HEADER);
 
@@ -2100,6 +2115,7 @@ void RPC_ENTRY NdrAsyncServerCall(PRPC_MESSAGE pRpcMsg)
                                     pProcHeader->Oi_flags & Oi_OBJECT_PROC,
                                     /* reuse the correlation cache, it's not needed for v1 format */
                                     async_call_data->NdrCorrCache, sizeof(async_call_data->NdrCorrCache), &async_call_data->number_of_params );
+        async_call_data->buffer_size = 0;
     }
 
     /* convert strings, floating point values and endianness into our
@@ -2150,6 +2166,8 @@ RPC_STATUS NdrpCompleteAsyncServerCall(RPC_ASYNC_STATE *pAsync, void *Reply)
     else
         TRACE("void stub implementation\n");
 
+    pStubMsg->BufferLength = async_call_data->buffer_size;
+
     for (phase = STUBLESS_CALCSIZE; phase <= STUBLESS_FREE; phase++)
     {
         TRACE("phase = %d\n", phase);
@@ -240,7 +240,7 @@ static RPC_STATUS RpcAssoc_BindConnection(const RpcAssoc *assoc, RpcConnection *
     TRACE("sending bind request to server\n");
 
     hdr = RPCRT4_BuildBindHeader(NDR_LOCAL_DATA_REPRESENTATION,
-                                 RPC_MAX_PACKET_SIZE, RPC_MAX_PACKET_SIZE,
+                                 conn->MaxTransmissionSize, conn->MaxTransmissionSize,
                                  assoc->assoc_group_id,
                                  InterfaceId, TransferSyntax);
 
@@ -182,6 +182,8 @@ typedef struct
 
 #define RPC_MIN_PACKET_SIZE  0x1000
 #define RPC_MAX_PACKET_SIZE  0x16D0
+/* ncalrpc only ever talks to a local peer, allow bigger fragments */
+#define RPC_MAX_LRPC_PACKET_SIZE  0xFFF8
 
 enum rpc_packet_type
 {
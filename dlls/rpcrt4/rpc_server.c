@@ -319,8 +319,8 @@ static RPC_STATUS process_bind_packet_no_send(
   }
 
   *ack_response = RPCRT4_BuildBindAckHeader(NDR_LOCAL_DATA_REPRESENTATION,
-                                            RPC_MAX_PACKET_SIZE,
-                                            RPC_MAX_PACKET_SIZE,
+                                            conn->MaxTransmissionSize,
+                                            conn->MaxTransmissionSize,
                                             conn->server_binding->Assoc->assoc_group_id,
                                             conn->Endpoint, hdr->num_elements,
                                             results);
@@ -98,7 +98,7 @@ static RPC_STATUS rpcrt4_conn_create_pipe(RpcConnection *conn)
     connection->pipe = CreateNamedPipeA(connection->listen_pipe, PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
                                         PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE,
                                         PIPE_UNLIMITED_INSTANCES,
-                                        RPC_MAX_PACKET_SIZE, RPC_MAX_PACKET_SIZE, 5000, NULL);
+                                        conn->MaxTransmissionSize, conn->MaxTransmissionSize, 5000, NULL);
     if (connection->pipe == INVALID_HANDLE_VALUE)
     {
         WARN("CreateNamedPipe failed with error %ld\n", GetLastError());
@@ -468,6 +468,89 @@ static int rpcrt4_conn_np_wait_for_incoming_data(RpcConnection *conn)
     return rpcrt4_conn_np_read(conn, NULL, 0);
 }
 
+/* Our pipes are in message mode and each fragment is written at once, so read it
+ * with a single request instead of reading the headers and payload separately. */
+static RPC_STATUS rpcrt4_conn_np_receive_fragment(RpcConnection *conn, RpcPktHdr **Header, void **Payload)
+{
+    unsigned int size = max(conn->MaxTransmissionSize, RPC_MAX_PACKET_SIZE);
+    RpcPktCommonHdr *common_hdr;
+    DWORD hdr_length;
+    RPC_STATUS status;
+    char *buffer, *tmp;
+    int count, ret;
+
+    *Header = NULL;
+    *Payload = NULL;
+
+    if (!(buffer = malloc(size)))
+        return RPC_S_OUT_OF_RESOURCES;
+
+    count = rpcrt4_conn_np_read(conn, buffer, size);
+    if (count < (int)sizeof(*common_hdr))
+    {
+        WARN("Short read of header, %d bytes\n", count);
+        status = RPC_S_CALL_FAILED;
+        goto done;
+    }
+
+    common_hdr = (RpcPktCommonHdr *)buffer;
+    if ((status = RPCRT4_ValidateCommonHeader(common_hdr)))
+        goto done;
+    hdr_length = RPCRT4_GetHeaderSize((RpcPktHdr *)common_hdr);
+
+    if (count < common_hdr->frag_len)
+    {
+        /* the peer may use bigger fragments than we do, read the rest of the message */
+        if (count != size || !(tmp = realloc(buffer, common_hdr->frag_len)))
+        {
+            WARN("bad fragment length, %d/%d\n", count, common_hdr->frag_len);
+            status = count != size ? RPC_S_CALL_FAILED : RPC_S_OUT_OF_RESOURCES;
+            goto done;
+        }
+        buffer = tmp;
+        common_hdr = (RpcPktCommonHdr *)buffer;
+
+        ret = rpcrt4_conn_np_read(conn, buffer + count, common_hdr->frag_len - count);
+        if (ret != common_hdr->frag_len - count)
+        {
+            WARN("bad data length, %d/%d\n", ret, common_hdr->frag_len - count);
+            status = RPC_S_CALL_FAILED;
+            goto done;
+        }
+    }
+    else if (count > common_hdr->frag_len)
+    {
+        WARN("bad fragment length, %d/%d\n", count, common_hdr->frag_len);
+        status = RPC_S_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    if (!(*Header = malloc(hdr_length)))
+    {
+        status = RPC_S_OUT_OF_RESOURCES;
+        goto done;
+    }
+    memcpy(*Header, buffer, hdr_length);
+
+    if (common_hdr->frag_len > hdr_length)
+    {
+        if (!(*Payload = malloc(common_hdr->frag_len - hdr_length)))
+        {
+            free(*Header);
+            *Header = NULL;
+            status = RPC_S_OUT_OF_RESOURCES;
+            goto done;
+        }
+        memcpy(*Payload, buffer + hdr_length, common_hdr->frag_len - hdr_length);
+    }
+
+    status = RPC_S_OK;
+
+done:
+    free(buffer);
+    return status;
+}
+
 static size_t rpcrt4_ncacn_np_get_top_of_tower(unsigned char *tower_data,
                                                const char *networkaddr,
                                                const char *endpoint)
@@ -3131,7 +3214,7 @@ static const struct connection_ops conn_protseq_list[] = {
     rpcrt4_conn_np_wait_for_incoming_data,
     rpcrt4_ncacn_np_get_top_of_tower,
     rpcrt4_ncacn_np_parse_top_of_tower,
-    NULL,
+    rpcrt4_conn_np_receive_fragment,
     RPCRT4_default_is_authorized,
     RPCRT4_default_authorize,
     RPCRT4_default_secure_packet,
@@ -3154,7 +3237,7 @@ static const struct connection_ops conn_protseq_list[] = {
     rpcrt4_conn_np_wait_for_incoming_data,
     rpcrt4_ncalrpc_get_top_of_tower,
     rpcrt4_ncalrpc_parse_top_of_tower,
-    NULL,
+    rpcrt4_conn_np_receive_fragment,
     rpcrt4_ncalrpc_is_authorized,
     rpcrt4_ncalrpc_authorize,
     rpcrt4_ncalrpc_secure_packet,
@@ -3306,7 +3389,10 @@ RPC_STATUS RPCRT4_CreateConnection(RpcConnection** Connection, BOOL server,
   NewConnection->Endpoint = strdup(Endpoint);
   NewConnection->NetworkOptions = wcsdup(NetworkOptions);
   NewConnection->CookieAuth = wcsdup(CookieAuth);
-  NewConnection->MaxTransmissionSize = RPC_MAX_PACKET_SIZE;
+  if (!strcmp(ops->name, "ncalrpc"))
+    NewConnection->MaxTransmissionSize = RPC_MAX_LRPC_PACKET_SIZE;
+  else
+    NewConnection->MaxTransmissionSize = RPC_MAX_PACKET_SIZE;
   NewConnection->NextCallId = 1;
 
   SecInvalidateHandle(&NewConnection->ctx);
@@ -1987,6 +1987,34 @@ run_tests(void)
   test_handle_return();
 }
 
+static void
+benchmark_calls(const char *protseq)
+{
+  static const int calls = 10000, big_calls = 200, big_size = 64 * 1024;
+  LARGE_INTEGER freq, start, end;
+  int i, *big;
+
+  QueryPerformanceFrequency(&freq);
+
+  QueryPerformanceCounter(&start);
+  for (i = 0; i < calls; i++)
+    ok(square(i & 0xff) == (i & 0xff) * (i & 0xff), "wrong result for call %d\n", i);
+  QueryPerformanceCounter(&end);
+  trace("%s: %d small calls, %.1f us per call\n", protseq, calls,
+        (double)(end.QuadPart - start.QuadPart) * 1000000 / freq.QuadPart / calls);
+
+  /* 256K of arguments are split into several fragments */
+  big = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, big_size * sizeof(*big));
+  big[0] = 1;
+  QueryPerformanceCounter(&start);
+  for (i = 0; i < big_calls; i++)
+    ok(sum_conf_array(big, big_size) == 1, "wrong result for call %d\n", i);
+  QueryPerformanceCounter(&end);
+  trace("%s: %d calls with %Iu bytes, %.1f MB/s\n", protseq, big_calls, big_size * sizeof(*big),
+        (double)big_calls * big_size * sizeof(*big) / (1024 * 1024) * freq.QuadPart / (end.QuadPart - start.QuadPart));
+  HeapFree(GetProcessHeap(), 0, big);
+}
+
 static void
 set_auth_info(RPC_BINDING_HANDLE handle)
 {
@@ -2069,6 +2097,7 @@ client(const char *test)
     ok(RPC_S_OK == RpcBindingFromStringBindingA(binding, &IMixedServer_IfHandle), "RpcBindingFromStringBinding\n");
 
     run_tests(); /* can cause RPC_X_BAD_STUB_DATA exception */
+    if (winetest_interactive) benchmark_calls("ncalrpc");
     authinfo_test(RPC_PROTSEQ_LRPC, 0);
     test_I_RpcBindingInqLocalClientPID(RPC_PROTSEQ_LRPC, IMixedServer_IfHandle);
     test_is_server_listening(IMixedServer_IfHandle, RPC_S_OK);
@@ -2113,6 +2142,7 @@ client(const char *test)
 
     test_is_server_listening(IMixedServer_IfHandle, RPC_S_OK);
     run_tests();
+    if (winetest_interactive) benchmark_calls("ncacn_np");
     authinfo_test(RPC_PROTSEQ_NMP, 0);
     test_I_RpcBindingInqLocalClientPID(RPC_PROTSEQ_NMP, IMixedServer_IfHandle);
     test_is_server_listening(IMixedServer_IfHandle, RPC_S_OK);
@@ -27,6 +27,7 @@
 #include "wine/list.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(mfplat);
+WINE_DECLARE_DEBUG_CHANNEL(rtwq_latency);
 
 #define FIRST_USER_QUEUE_HANDLE 5
 #define MAX_USER_QUEUE_HANDLES 124
@@ -58,6 +59,8 @@ static struct queue_handle *next_free_user_queue;
 static struct queue_handle *next_unused_user_queue = user_queues;
 static WORD queue_generation;
 static DWORD shared_mt_queue;
+static DWORD shared_mmcss_queues[8];
+static LONG next_mmcss_taskid;
 
 static CRITICAL_SECTION queues_section;
 static CRITICAL_SECTION_DEBUG queues_critsect_debug =
@@ -131,6 +134,8 @@ struct work_item
     RTWQWORKITEM_KEY key;
     LONG priority;
     DWORD flags;
+    int thread_priority;
+    LARGE_INTEGER submit_time;
     TP_WORK *work_object;
     PTP_SIMPLE_CALLBACK finalization_callback;
     union
@@ -181,6 +186,11 @@ struct queue
     /* Data used for serial queues only. */
     PTP_SIMPLE_CALLBACK finalization_callback;
     DWORD target_queue;
+    /* Data used for queues serving an MMCSS class. */
+    WCHAR *mmcss_class;
+    DWORD mmcss_taskid;
+    LONG mmcss_priority;
+    int thread_priority;
 };
 
 static void shutdown_queue(struct queue *queue);
@@ -208,6 +218,7 @@ static HRESULT unlock_user_queue(DWORD queue)
 {
     HRESULT hr = RTWQ_E_INVALID_WORKQUEUE;
     struct queue_handle *entry;
+    unsigned int i;
 
     if (!(queue & RTWQ_CALLBACK_QUEUE_PRIVATE_MASK))
         return S_OK;
@@ -219,6 +230,8 @@ static HRESULT unlock_user_queue(DWORD queue)
         if (--entry->refcount == 0)
         {
             if (shared_mt_queue == queue) shared_mt_queue = 0;
+            for (i = 0; i < ARRAY_SIZE(shared_mmcss_queues); ++i)
+                if (shared_mmcss_queues[i] == queue) shared_mmcss_queues[i] = 0;
             shutdown_queue((struct queue *)entry->obj);
             free(entry->obj);
             entry->obj = next_free_user_queue;
@@ -332,7 +345,16 @@ static HRESULT pool_queue_init(const struct queue_desc *desc, struct queue *queu
     list_init(&queue->pending_items);
     InitializeCriticalSection(&queue->cs);
 
-    max_thread = (desc->queue_type == RTWQ_STANDARD_WORKQUEUE || desc->queue_type == RTWQ_WINDOW_WORKQUEUE) ? 1 : 4;
+    if (desc->queue_type == RTWQ_STANDARD_WORKQUEUE || desc->queue_type == RTWQ_WINDOW_WORKQUEUE)
+        max_thread = 1;
+    else
+    {
+        SYSTEM_INFO info;
+
+        /* Keep enough workers around so that long running items don't starve the rest. */
+        GetSystemInfo(&info);
+        max_thread = max(4, info.dwNumberOfProcessors);
+    }
 
     SetThreadpoolThreadMinimum(queue->pool, 1);
     SetThreadpoolThreadMaximum(queue->pool, max_thread);
@@ -359,15 +381,35 @@ static void CALLBACK standard_queue_worker(TP_CALLBACK_INSTANCE *instance, void
 {
     struct work_item *item = context;
     RTWQASYNCRESULT *result = (RTWQASYNCRESULT *)item->result;
+    int thread_priority = THREAD_PRIORITY_NORMAL;
 
     TRACE("result object %p.\n", result);
 
+    if (item->submit_time.QuadPart)
+    {
+        LARGE_INTEGER now, frequency;
+
+        QueryPerformanceCounter(&now);
+        QueryPerformanceFrequency(&frequency);
+        TRACE_(rtwq_latency)("queue %p, result %p, priority %ld, waited %I64u us.\n", item->queue, result,
+                item->priority, (now.QuadPart - item->submit_time.QuadPart) * 1000000 / frequency.QuadPart);
+    }
+
+    if (item->thread_priority != THREAD_PRIORITY_NORMAL)
+    {
+        thread_priority = GetThreadPriority(GetCurrentThread());
+        SetThreadPriority(GetCurrentThread(), item->thread_priority);
+    }
+
     /* Submitting from serial queue in reply mode, use different result object acting as receipt token.
        It's submitted to user callback still, but when invoked, special serial queue callback will be used
        to ensure correct destination queue. */
 
     IRtwqAsyncCallback_Invoke(result->pCallback, item->reply_result ? item->reply_result : item->result);
 
+    if (item->thread_priority != THREAD_PRIORITY_NORMAL)
+        SetThreadPriority(GetCurrentThread(), thread_priority);
+
     IUnknown_Release(&item->IUnknown_iface);
 }
 
@@ -385,6 +427,7 @@ static void pool_queue_submit(struct queue *queue, struct work_item *item)
 
     env = queue->envs[callback_priority];
     env.FinalizationCallback = item->finalization_callback;
+    item->thread_priority = queue->thread_priority;
     /* Worker pool callback will release one reference. Grab one more to keep object alive when
        we need finalization callback. */
     if (item->finalization_callback)
@@ -584,6 +627,8 @@ static struct work_item * alloc_work_item(struct queue *queue, LONG priority, IR
     item->queue = queue;
     list_init(&item->entry);
     item->priority = priority;
+    if (TRACE_ON(rtwq_latency))
+        QueryPerformanceCounter(&item->submit_time);
 
     if (SUCCEEDED(IRtwqAsyncCallback_GetParameters(async_result->pCallback, &flags, &queue_id)))
         item->flags = flags;
@@ -639,6 +684,8 @@ static HRESULT grab_queue(DWORD queue_id, struct queue **ret)
         desc.ops = &pool_queue_ops;
         desc.target_queue = 0;
         init_work_queue(&desc, queue);
+        if (queue_id == RTWQ_CALLBACK_QUEUE_RT)
+            queue->thread_priority = THREAD_PRIORITY_HIGHEST;
         LeaveCriticalSection(&queues_section);
         *ret = queue;
         return S_OK;
@@ -668,6 +715,7 @@ static void shutdown_queue(struct queue *queue)
 
     DeleteCriticalSection(&queue->cs);
 
+    free(queue->mmcss_class);
     memset(queue, 0, sizeof(*queue));
 }
 
@@ -1436,6 +1484,69 @@ HRESULT WINAPI RtwqSetLongRunning(DWORD queue_id, BOOL enable)
     return hr;
 }
 
+static int get_mmcss_thread_priority(const WCHAR *class, LONG base_priority)
+{
+    static const WCHAR *audio_classes[] = { L"Audio", L"Capture", L"Distribution", L"Playback" };
+    int priority = THREAD_PRIORITY_ABOVE_NORMAL;
+    unsigned int i;
+
+    if (!wcsicmp(class, L"Pro Audio"))
+        return THREAD_PRIORITY_TIME_CRITICAL;
+
+    for (i = 0; i < ARRAY_SIZE(audio_classes); ++i)
+        if (!wcsicmp(class, audio_classes[i])) priority = THREAD_PRIORITY_HIGHEST;
+
+    return min(max(priority + base_priority, THREAD_PRIORITY_NORMAL), THREAD_PRIORITY_HIGHEST);
+}
+
+/* Shared queues for a given MMCSS class get their own pool, so that their items are never
+   queued behind unrelated work. Called with queues_section held. */
+static HRESULT lock_shared_mmcss_queue(const WCHAR *class, LONG priority, DWORD *taskid, DWORD *queue_id)
+{
+    struct queue_desc desc;
+    struct queue *queue;
+    unsigned int i;
+    HRESULT hr;
+
+    for (i = 0; i < ARRAY_SIZE(shared_mmcss_queues); ++i)
+    {
+        if (!shared_mmcss_queues[i] || FAILED(grab_queue(shared_mmcss_queues[i], &queue)))
+            continue;
+        if (wcsicmp(queue->mmcss_class, class) || queue->mmcss_priority != priority)
+            continue;
+
+        if (SUCCEEDED(hr = lock_user_queue(shared_mmcss_queues[i])))
+        {
+            if (taskid) *taskid = queue->mmcss_taskid;
+            *queue_id = shared_mmcss_queues[i];
+        }
+        return hr;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(shared_mmcss_queues); ++i)
+        if (!shared_mmcss_queues[i]) break;
+
+    desc.queue_type = RTWQ_MULTITHREADED_WORKQUEUE;
+    desc.ops = &pool_queue_ops;
+    desc.target_queue = 0;
+    if (FAILED(hr = alloc_user_queue(&desc, queue_id)))
+        return hr;
+
+    grab_queue(*queue_id, &queue);
+    queue->mmcss_class = wcsdup(class);
+    queue->mmcss_priority = priority;
+    queue->mmcss_taskid = taskid && *taskid ? *taskid : InterlockedIncrement(&next_mmcss_taskid);
+    queue->thread_priority = get_mmcss_thread_priority(class, priority);
+    if (i < ARRAY_SIZE(shared_mmcss_queues))
+        shared_mmcss_queues[i] = *queue_id;
+
+    TRACE("Created queue %#lx for class %s, task id %lu, thread priority %d.\n", *queue_id, debugstr_w(class),
+            queue->mmcss_taskid, queue->thread_priority);
+
+    if (taskid) *taskid = queue->mmcss_taskid;
+    return S_OK;
+}
+
 HRESULT WINAPI RtwqLockSharedWorkQueue(const WCHAR *usageclass, LONG priority, DWORD *taskid, DWORD *queue)
 {
     struct queue_desc desc;
@@ -1449,22 +1560,24 @@ HRESULT WINAPI RtwqLockSharedWorkQueue(const WCHAR *usageclass, LONG priority, D
     if (!*usageclass && taskid)
         return E_INVALIDARG;
 
-    if (*usageclass)
-        FIXME("Class name is ignored.\n");
-
     EnterCriticalSection(&queues_section);
 
-    if (shared_mt_queue)
-        hr = lock_user_queue(shared_mt_queue);
+    if (*usageclass)
+        hr = lock_shared_mmcss_queue(usageclass, priority, taskid, queue);
     else
     {
-        desc.queue_type = RTWQ_MULTITHREADED_WORKQUEUE;
-        desc.ops = &pool_queue_ops;
-        desc.target_queue = 0;
-        hr = alloc_user_queue(&desc, &shared_mt_queue);
-    }
+        if (shared_mt_queue)
+            hr = lock_user_queue(shared_mt_queue);
+        else
+        {
+            desc.queue_type = RTWQ_MULTITHREADED_WORKQUEUE;
+            desc.ops = &pool_queue_ops;
+            desc.target_queue = 0;
+            hr = alloc_user_queue(&desc, &shared_mt_queue);
+        }
 
-    *queue = shared_mt_queue;
+        *queue = shared_mt_queue;
+    }
 
     LeaveCriticalSection(&queues_section);
 
@@ -1518,25 +1631,74 @@ HRESULT WINAPI RtwqUnjoinWorkQueue(DWORD queue, HANDLE cookie)
     return E_NOTIMPL;
 }
 
-HRESULT WINAPI RtwqGetWorkQueueMMCSSClass(DWORD queue, WCHAR *class, DWORD *length)
+HRESULT WINAPI RtwqGetWorkQueueMMCSSClass(DWORD queue_id, WCHAR *class, DWORD *length)
 {
-    FIXME("%#lx, %p, %p.\n", queue, class, length);
+    struct queue *queue;
+    DWORD size;
+    HRESULT hr;
 
-    return E_NOTIMPL;
+    TRACE("%#lx, %p, %p.\n", queue_id, class, length);
+
+    if (!length)
+        return E_POINTER;
+
+    lock_user_queue(queue_id);
+
+    if (SUCCEEDED(hr = grab_queue(queue_id, &queue)))
+    {
+        size = queue->mmcss_class ? wcslen(queue->mmcss_class) + 1 : 1;
+        if (!class || *length < size)
+            hr = HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+        else if (queue->mmcss_class)
+            memcpy(class, queue->mmcss_class, size * sizeof(*class));
+        else
+            *class = 0;
+        *length = size;
+    }
+
+    unlock_user_queue(queue_id);
+
+    return hr;
 }
 
-HRESULT WINAPI RtwqGetWorkQueueMMCSSTaskId(DWORD queue, DWORD *taskid)
+HRESULT WINAPI RtwqGetWorkQueueMMCSSTaskId(DWORD queue_id, DWORD *taskid)
 {
-    FIXME("%#lx, %p.\n", queue, taskid);
+    struct queue *queue;
+    HRESULT hr;
 
-    return E_NOTIMPL;
+    TRACE("%#lx, %p.\n", queue_id, taskid);
+
+    if (!taskid)
+        return E_POINTER;
+
+    lock_user_queue(queue_id);
+
+    if (SUCCEEDED(hr = grab_queue(queue_id, &queue)))
+        *taskid = queue->mmcss_taskid;
+
+    unlock_user_queue(queue_id);
+
+    return hr;
 }
 
-HRESULT WINAPI RtwqGetWorkQueueMMCSSPriority(DWORD queue, LONG *priority)
+HRESULT WINAPI RtwqGetWorkQueueMMCSSPriority(DWORD queue_id, LONG *priority)
 {
-    FIXME("%#lx, %p.\n", queue, priority);
+    struct queue *queue;
+    HRESULT hr;
 
-    return E_NOTIMPL;
+    TRACE("%#lx, %p.\n", queue_id, priority);
+
+    if (!priority)
+        return E_POINTER;
+
+    lock_user_queue(queue_id);
+
+    if (SUCCEEDED(hr = grab_queue(queue_id, &queue)))
+        *priority = queue->mmcss_priority;
+
+    unlock_user_queue(queue_id);
+
+    return hr;
 }
 
 HRESULT WINAPI RtwqRegisterPlatformWithMMCSS(const WCHAR *class, DWORD *taskid, LONG priority)
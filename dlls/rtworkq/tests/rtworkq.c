@@ -101,7 +101,58 @@ static void test_platform_init(void)
     ok(hr == S_OK, "Failed to shut down, hr %#lx.\n", hr);
 }
 
+static void test_shared_mmcss_queue(void)
+{
+    DWORD queue, queue2, taskid, taskid2, length;
+    WCHAR class[32];
+    HRESULT hr;
+
+    hr = RtwqStartup();
+    ok(hr == S_OK, "Failed to start up, hr %#lx.\n", hr);
+
+    taskid = 0;
+    hr = RtwqLockSharedWorkQueue(L"Audio", 0, &taskid, &queue);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    ok(!!taskid, "Unexpected task id %#lx.\n", taskid);
+
+    taskid2 = 0;
+    hr = RtwqLockSharedWorkQueue(L"Audio", 0, &taskid2, &queue2);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    ok(queue2 == queue, "Unexpected queue %#lx.\n", queue2);
+    ok(taskid2 == taskid, "Unexpected task id %#lx.\n", taskid2);
+
+    hr = RtwqUnlockWorkQueue(queue2);
+    ok(hr == S_OK, "Failed to unlock the queue, hr %#lx.\n", hr);
+
+    hr = RtwqLockSharedWorkQueue(L"", 0, NULL, &queue2);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    ok(queue2 != queue, "Unexpected queue %#lx.\n", queue2);
+
+    hr = RtwqUnlockWorkQueue(queue2);
+    ok(hr == S_OK, "Failed to unlock the queue, hr %#lx.\n", hr);
+
+    length = ARRAY_SIZE(class);
+    hr = RtwqGetWorkQueueMMCSSClass(queue, class, &length);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    if (hr == S_OK)
+    {
+        ok(!wcscmp(class, L"Audio"), "Unexpected class %s.\n", wine_dbgstr_w(class));
+        ok(length == 6, "Unexpected length %lu.\n", length);
+    }
+
+    hr = RtwqGetWorkQueueMMCSSTaskId(queue, &taskid2);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    ok(taskid2 == taskid, "Unexpected task id %#lx.\n", taskid2);
+
+    hr = RtwqUnlockWorkQueue(queue);
+    ok(hr == S_OK, "Failed to unlock the queue, hr %#lx.\n", hr);
+
+    hr = RtwqShutdown();
+    ok(hr == S_OK, "Failed to shut down, hr %#lx.\n", hr);
+}
+
 START_TEST(rtworkq)
 {
     test_platform_init();
+    test_shared_mmcss_queue();
 }
@@ -30,8 +30,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <time.h>
 #include <sys/types.h>
 #include <dlfcn.h>
+#include <pthread.h>
 #ifdef SONAME_LIBGNUTLS
 #include <gnutls/gnutls.h>
 #include <gnutls/crypto.h>
@@ -48,6 +50,7 @@
 
 #include "wine/unixlib.h"
 #include "wine/debug.h"
+#include "wine/list.h"
 
 #if defined(SONAME_LIBGNUTLS)
 
@@ -79,6 +82,11 @@ static int (*pgnutls_privkey_import_rsa_raw)(gnutls_privkey_t, const gnutls_datu
 
 /* Not present in gnutls version < 3.4.0. */
 static int (*pgnutls_privkey_export_x509)(gnutls_privkey_t, gnutls_x509_privkey_t *);
+static int (*pgnutls_certificate_get_crt_raw)(gnutls_certificate_credentials_t, unsigned, unsigned,
+                                              gnutls_datum_t *);
+
+/* Not present in gnutls version < 3.5.0. */
+static unsigned int (*pgnutls_session_get_flags)(gnutls_session_t);
 
 static void *libgnutls_handle;
 #define MAKE_FUNCPTR(f) static typeof(f) * p##f
@@ -98,6 +106,7 @@ MAKE_FUNCPTR(gnutls_global_init);
 MAKE_FUNCPTR(gnutls_global_set_log_function);
 MAKE_FUNCPTR(gnutls_global_set_log_level);
 MAKE_FUNCPTR(gnutls_handshake);
+MAKE_FUNCPTR(gnutls_hash_fast);
 MAKE_FUNCPTR(gnutls_init);
 MAKE_FUNCPTR(gnutls_kx_get);
 MAKE_FUNCPTR(gnutls_mac_get);
@@ -112,6 +121,9 @@ MAKE_FUNCPTR(gnutls_record_recv);
 MAKE_FUNCPTR(gnutls_record_send);
 MAKE_FUNCPTR(gnutls_server_name_set);
 MAKE_FUNCPTR(gnutls_session_channel_binding);
+MAKE_FUNCPTR(gnutls_session_get_data);
+MAKE_FUNCPTR(gnutls_session_is_resumed);
+MAKE_FUNCPTR(gnutls_session_set_data);
 MAKE_FUNCPTR(gnutls_set_default_priority);
 MAKE_FUNCPTR(gnutls_transport_get_ptr);
 MAKE_FUNCPTR(gnutls_transport_set_errno);
@@ -146,6 +158,12 @@ MAKE_FUNCPTR(gnutls_x509_privkey_deinit);
 #define GNUTLS_ALPN_SERVER_PRECEDENCE (1<<1)
 #endif
 
+#if GNUTLS_VERSION_MAJOR < 3 || (GNUTLS_VERSION_MAJOR == 3 && GNUTLS_VERSION_MINOR < 6) || \
+    (GNUTLS_VERSION_MAJOR == 3 && GNUTLS_VERSION_MINOR == 6 && GNUTLS_VERSION_PATCH < 3)
+#define GNUTLS_TLS1_3 5
+#define GNUTLS_SFLAGS_SESSION_TICKET (1<<7)
+#endif
+
 static inline gnutls_session_t session_from_handle(UINT64 handle)
 {
    return (gnutls_session_t)(ULONG_PTR)handle;
@@ -169,8 +187,35 @@ struct schan_transport
     gnutls_session_t session;
     struct schan_buffers in;
     struct schan_buffers out;
+    BOOL client;
+    DWORD enabled_protocols;
+    BOOL cacheable;
+    char cert_hash[65];
+    char *cache_key;
+    BOOL handshake_done;
+    BOOL cached;
+};
+
+/* client sessions are cached per target name, protocols and client
+ * certificate, so that new connections to the same server can resume them */
+#define SESSION_CACHE_SIZE 256
+#define SESSION_CACHE_TIMEOUT (10 * 60 * 60) /* native ClientCacheTime default */
+
+struct session_cache_entry
+{
+    struct list entry;
+    const char *key;
+    time_t expiry;
+    BOOL single_use;
+    size_t size;
+    unsigned char data[1];
 };
 
+static struct list session_cache = LIST_INIT( session_cache );
+static unsigned int session_cache_count;
+static pthread_mutex_t session_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static LONG full_handshakes, resumed_handshakes;
+
 static int compat_cipher_get_block_size(gnutls_cipher_algorithm_t cipher)
 {
     switch(cipher) {
@@ -240,6 +285,17 @@ static void compat_gnutls_dtls_set_timeouts(gnutls_session_t session, unsigned i
     FIXME("\n");
 }
 
+static int compat_gnutls_certificate_get_crt_raw(gnutls_certificate_credentials_t creds, unsigned idx1,
+        unsigned idx2, gnutls_datum_t *cert)
+{
+    return GNUTLS_E_INVALID_REQUEST;
+}
+
+static unsigned int compat_gnutls_session_get_flags(gnutls_session_t session)
+{
+    return 0;
+}
+
 static void init_schan_buffers(struct schan_buffers *s, const PSecBufferDesc desc)
 {
     s->offset = 0;
@@ -497,8 +553,11 @@ static NTSTATUS schan_create_session( void *args )
     schan_credentials *cred = params->cred;
     unsigned int flags = (cred->credential_use == SECPKG_CRED_INBOUND) ? GNUTLS_SERVER : GNUTLS_CLIENT;
     struct schan_transport *transport;
+    unsigned char hash[32];
+    gnutls_datum_t cert;
     gnutls_session_t s;
     NTSTATUS status;
+    unsigned int i;
     int err;
 
     *params->session = 0;
@@ -538,6 +597,19 @@ static NTSTATUS schan_create_session( void *args )
         return STATUS_INTERNAL_ERROR;
     }
 
+    transport->client = !(flags & GNUTLS_SERVER);
+    transport->enabled_protocols = cred->enabled_protocols;
+    /* sessions established with a client certificate are only resumed
+     * with the same certificate, identified by the hash of its DER */
+    err = pgnutls_certificate_get_crt_raw( certificate_creds_from_handle(cred->credentials), 0, 0, &cert );
+    if (err == GNUTLS_E_REQUESTED_DATA_NOT_AVAILABLE)
+        transport->cacheable = TRUE;
+    else if (err == GNUTLS_E_SUCCESS && !pgnutls_hash_fast( GNUTLS_DIG_SHA256, cert.data, cert.size, hash ))
+    {
+        for (i = 0; i < sizeof(hash); i++) sprintf( transport->cert_hash + 2 * i, "%02x", hash[i] );
+        transport->cacheable = TRUE;
+    }
+
     pgnutls_transport_set_pull_function(s, pull_adapter);
     if (flags & GNUTLS_DATAGRAM) pgnutls_transport_set_pull_timeout_function(s, pull_timeout);
     pgnutls_transport_set_push_function(s, push_adapter);
@@ -547,13 +619,90 @@ static NTSTATUS schan_create_session( void *args )
     return STATUS_SUCCESS;
 }
 
+static void free_session_cache_entry( struct session_cache_entry *entry )
+{
+    list_remove( &entry->entry );
+    session_cache_count--;
+    free( entry );
+}
+
+static void resume_cached_session( struct schan_transport *t )
+{
+    struct session_cache_entry *entry;
+    time_t now = time( NULL );
+    int err;
+
+    pthread_mutex_lock( &session_cache_mutex );
+    LIST_FOR_EACH_ENTRY( entry, &session_cache, struct session_cache_entry, entry )
+    {
+        if (strcmp( entry->key, t->cache_key )) continue;
+
+        if (entry->expiry <= now)
+            free_session_cache_entry( entry );
+        else if ((err = pgnutls_session_set_data( t->session, entry->data, entry->size )) != GNUTLS_E_SUCCESS)
+            pgnutls_perror( err );
+        else
+        {
+            TRACE( "trying to resume session for %s\n", debugstr_a(t->cache_key) );
+            /* TLS 1.3 tickets must not be reused (RFC 8446, appendix C.4) */
+            if (entry->single_use) free_session_cache_entry( entry );
+        }
+        break;
+    }
+    pthread_mutex_unlock( &session_cache_mutex );
+}
+
+static void cache_session( struct schan_transport *t )
+{
+    struct session_cache_entry *entry, *old, *next;
+    size_t size = 0, key_len = strlen( t->cache_key ) + 1;
+    time_t now = time( NULL );
+    int err;
+
+    /* TLS 1.3 session data is only resumable once the server sent a ticket */
+    if (pgnutls_protocol_get_version( t->session ) == GNUTLS_TLS1_3 &&
+        !(pgnutls_session_get_flags( t->session ) & GNUTLS_SFLAGS_SESSION_TICKET))
+        return;
+
+    if ((err = pgnutls_session_get_data( t->session, NULL, &size )) != GNUTLS_E_SUCCESS)
+    {
+        pgnutls_perror( err );
+        return;
+    }
+    if (!size || !(entry = malloc( offsetof( struct session_cache_entry, data[size] ) + key_len ))) return;
+    if ((err = pgnutls_session_get_data( t->session, entry->data, &size )) != GNUTLS_E_SUCCESS)
+    {
+        pgnutls_perror( err );
+        free( entry );
+        return;
+    }
+    entry->key = memcpy( entry->data + size, t->cache_key, key_len );
+    entry->expiry = now + SESSION_CACHE_TIMEOUT;
+    entry->single_use = pgnutls_protocol_get_version( t->session ) == GNUTLS_TLS1_3;
+    entry->size = size;
+    t->cached = TRUE;
+
+    pthread_mutex_lock( &session_cache_mutex );
+    LIST_FOR_EACH_ENTRY_SAFE( old, next, &session_cache, struct session_cache_entry, entry )
+    {
+        if (!strcmp( old->key, entry->key ) || old->expiry <= now) free_session_cache_entry( old );
+    }
+    if (session_cache_count >= SESSION_CACHE_SIZE)
+        free_session_cache_entry( LIST_ENTRY( list_tail( &session_cache ), struct session_cache_entry, entry ) );
+    list_add_head( &session_cache, &entry->entry );
+    session_cache_count++;
+    pthread_mutex_unlock( &session_cache_mutex );
+}
+
 static NTSTATUS schan_dispose_session( void *args )
 {
     const struct session_params *params = args;
     gnutls_session_t s = session_from_handle(params->session);
     struct schan_transport *t = (struct schan_transport *)pgnutls_transport_get_ptr(s);
+    if (t->cache_key && t->handshake_done && !t->cached) cache_session(t);
     pgnutls_transport_set_ptr(s, NULL);
     pgnutls_deinit(s);
+    free(t->cache_key);
     free(t);
     return STATUS_SUCCESS;
 }
@@ -562,7 +711,18 @@ static NTSTATUS schan_set_session_target( void *args )
 {
     const struct set_session_target_params *params = args;
     gnutls_session_t s = session_from_handle(params->session);
+    struct schan_transport *t = (struct schan_transport *)pgnutls_transport_get_ptr(s);
+    size_t len;
+
     pgnutls_server_name_set( s, GNUTLS_NAME_DNS, params->target, strlen(params->target) );
+
+    if (!t->client || !t->cacheable || (t->enabled_protocols & SP_PROT_DTLS1_X)) return STATUS_SUCCESS;
+
+    free( t->cache_key );
+    len = strlen( params->target ) + 1 + 8 + 1 + sizeof(t->cert_hash);
+    if (!(t->cache_key = malloc( len ))) return STATUS_SUCCESS;
+    snprintf( t->cache_key, len, "%s:%08x:%s", params->target, (unsigned int)t->enabled_protocols, t->cert_hash );
+    resume_cached_session( t );
     return STATUS_SUCCESS;
 }
 
@@ -659,6 +819,14 @@ static NTSTATUS schan_handshake( void *args )
         {
             TRACE("Handshake completed\n");
             status = SEC_E_OK;
+            if (t->client && !t->handshake_done)
+            {
+                if (pgnutls_session_is_resumed(s)) InterlockedIncrement(&resumed_handshakes);
+                else InterlockedIncrement(&full_handshakes);
+                TRACE("%d full, %d resumed client handshakes\n", (int)full_handshakes, (int)resumed_handshakes);
+            }
+            t->handshake_done = TRUE;
+            if (t->cache_key && !t->cached) cache_session(t);
         }
         else if (err == GNUTLS_E_AGAIN)
         {
@@ -1189,6 +1357,9 @@ static NTSTATUS schan_recv( void *args )
         }
     }
 
+    /* TLS 1.3 session tickets arrive after the handshake */
+    if (t->cache_key && t->handshake_done && !t->cached) cache_session(t);
+
     *params->length = received;
     return status;
 }
@@ -1500,6 +1671,7 @@ static NTSTATUS process_attach( void *args )
     LOAD_FUNCPTR(gnutls_global_set_log_function)
     LOAD_FUNCPTR(gnutls_global_set_log_level)
     LOAD_FUNCPTR(gnutls_handshake)
+    LOAD_FUNCPTR(gnutls_hash_fast)
     LOAD_FUNCPTR(gnutls_init)
     LOAD_FUNCPTR(gnutls_kx_get)
     LOAD_FUNCPTR(gnutls_mac_get)
@@ -1514,6 +1686,9 @@ static NTSTATUS process_attach( void *args )
     LOAD_FUNCPTR(gnutls_record_send);
     LOAD_FUNCPTR(gnutls_server_name_set)
     LOAD_FUNCPTR(gnutls_session_channel_binding)
+    LOAD_FUNCPTR(gnutls_session_get_data)
+    LOAD_FUNCPTR(gnutls_session_is_resumed)
+    LOAD_FUNCPTR(gnutls_session_set_data)
     LOAD_FUNCPTR(gnutls_set_default_priority)
     LOAD_FUNCPTR(gnutls_transport_get_ptr)
     LOAD_FUNCPTR(gnutls_transport_set_errno)
@@ -1566,6 +1741,16 @@ static NTSTATUS process_attach( void *args )
         WARN("gnutls_privkey_import_rsa_raw not found\n");
         pgnutls_privkey_import_rsa_raw = compat_gnutls_privkey_import_rsa_raw;
     }
+    if (!(pgnutls_certificate_get_crt_raw = dlsym(libgnutls_handle, "gnutls_certificate_get_crt_raw")))
+    {
+        WARN("gnutls_certificate_get_crt_raw not found\n");
+        pgnutls_certificate_get_crt_raw = compat_gnutls_certificate_get_crt_raw;
+    }
+    if (!(pgnutls_session_get_flags = dlsym(libgnutls_handle, "gnutls_session_get_flags")))
+    {
+        WARN("gnutls_session_get_flags not found\n");
+        pgnutls_session_get_flags = compat_gnutls_session_get_flags;
+    }
 
     ret = pgnutls_global_init();
     if (ret != GNUTLS_E_SUCCESS)
@@ -1592,6 +1777,12 @@ fail:
 
 static NTSTATUS process_detach( void *args )
 {
+    struct session_cache_entry *entry, *next;
+
+    TRACE("%d full, %d resumed client handshakes\n", (int)full_handshakes, (int)resumed_handshakes);
+    LIST_FOR_EACH_ENTRY_SAFE( entry, next, &session_cache, struct session_cache_entry, entry )
+        free_session_cache_entry( entry );
+
     pgnutls_global_deinit();
     dlclose(libgnutls_handle);
     libgnutls_handle = NULL;
@@ -1491,6 +1491,41 @@ static HRESULT fill_array_desc(compile_ctx_t *ctx, dim_decl_t *dim_decl, array_d
     return S_OK;
 }
 
+static BOOL is_member_instr(const instr_t *instr)
+{
+    switch(instr->op) {
+    case OP_mcall:
+    case OP_mcallv:
+    case OP_assign_member:
+    case OP_set_member:
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+static HRESULT alloc_member_cache(compile_ctx_t *ctx, function_t *func)
+{
+    unsigned i, cnt = 0;
+
+    for(i = func->code_off; i < ctx->instr_cnt; i++) {
+        if(is_member_instr(ctx->code->instrs + i))
+            cnt++;
+    }
+    if(!cnt)
+        return S_OK;
+
+    func->member_cache = compiler_alloc_zero(ctx->code, cnt * sizeof(*func->member_cache));
+    if(!func->member_cache)
+        return E_OUTOFMEMORY;
+
+    for(i = func->code_off; i < ctx->instr_cnt; i++) {
+        if(is_member_instr(ctx->code->instrs + i))
+            func->member_cache[func->member_cache_cnt++].instr = i;
+    }
+    return S_OK;
+}
+
 static HRESULT compile_func(compile_ctx_t *ctx, statement_t *stat, function_t *func)
 {
     HRESULT hres;
@@ -1543,6 +1578,10 @@ static HRESULT compile_func(compile_ctx_t *ctx, statement_t *stat, function_t *f
 
     resolve_labels(ctx, func->code_off);
 
+    hres = alloc_member_cache(ctx, func);
+    if(FAILED(hres))
+        return hres;
+
     if(func->var_cnt) {
         dim_decl_t *dim_decl;
         unsigned i;
@@ -748,12 +748,82 @@ static HRESULT interp_vcallv(exec_ctx_t *ctx)
     return hres;
 }
 
+static member_cache_entry_t *get_member_cache_entry(exec_ctx_t *ctx)
+{
+    member_cache_entry_t *cache = ctx->func->member_cache;
+    unsigned min = 0, max = ctx->func->member_cache_cnt, i;
+    const unsigned instr = ctx->instr - ctx->code->instrs;
+
+    while(min < max) {
+        i = (min + max) / 2;
+        if(cache[i].instr == instr)
+            return cache + i;
+        if(cache[i].instr < instr)
+            min = i + 1;
+        else
+            max = i;
+    }
+
+    return NULL;
+}
+
+/*
+ * Looks up the DISPID of a member of an external object, using the cache of
+ * the current instruction if the object was already seen there. Checking the
+ * cache makes no calls on the object, which is what makes it worth it for
+ * remote objects. The object isn't referenced by the cache, so its address
+ * may be reused by another object. The callers look the DISPID up again if
+ * Invoke returns DISP_E_MEMBERNOTFOUND for a cached one.
+ */
+static HRESULT get_member_id(exec_ctx_t *ctx, IDispatch *obj, BSTR name, vbdisp_invoke_type_t invoke_type,
+        DISPID *id, BOOL *cached)
+{
+    member_cache_entry_t *entry;
+    HRESULT hres;
+
+    *cached = FALSE;
+
+    /* Lookups on script class instances are cheap. */
+    if(is_vbdisp(obj) || !(entry = get_member_cache_entry(ctx)))
+        return disp_get_id(obj, name, invoke_type, FALSE, id);
+
+    if(entry->disp == obj && entry->vtbl == obj->lpVtbl) {
+        ctx->script->member_cache_hits++;
+        *id = entry->id;
+        *cached = TRUE;
+        return S_OK;
+    }
+
+    ctx->script->member_cache_misses++;
+    hres = disp_get_id(obj, name, invoke_type, FALSE, id);
+    if(FAILED(hres))
+        return hres;
+
+    entry->disp = obj;
+    entry->vtbl = obj->lpVtbl;
+    entry->id = *id;
+    return S_OK;
+}
+
+static HRESULT refresh_member_id(exec_ctx_t *ctx, IDispatch *obj, BSTR name, vbdisp_invoke_type_t invoke_type,
+        DISPID *id)
+{
+    member_cache_entry_t *entry = get_member_cache_entry(ctx);
+    BOOL cached;
+
+    TRACE("%s\n", debugstr_w(name));
+
+    entry->disp = NULL;
+    return get_member_id(ctx, obj, name, invoke_type, id, &cached);
+}
+
 static HRESULT do_mcall(exec_ctx_t *ctx, VARIANT *res)
 {
     const BSTR identifier = ctx->instr->arg1.bstr;
     const unsigned arg_cnt = ctx->instr->arg2.uint;
     IDispatch *obj;
     DISPPARAMS dp;
+    BOOL cached;
     DISPID id;
     HRESULT hres;
 
@@ -768,9 +838,14 @@ static HRESULT do_mcall(exec_ctx_t *ctx, VARIANT *res)
 
     vbstack_to_dp(ctx, arg_cnt, FALSE, &dp);
 
-    hres = disp_get_id(obj, identifier, VBDISP_CALLGET, FALSE, &id);
+    hres = get_member_id(ctx, obj, identifier, VBDISP_CALLGET, &id, &cached);
     if(SUCCEEDED(hres))
         hres = disp_call(ctx->script, obj, id, &dp, res);
+    if(hres == DISP_E_MEMBERNOTFOUND && cached) {
+        hres = refresh_member_id(ctx, obj, identifier, VBDISP_CALLGET, &id);
+        if(SUCCEEDED(hres))
+            hres = disp_call(ctx->script, obj, id, &dp, res);
+    }
     IDispatch_Release(obj);
     if(FAILED(hres))
         return hres;
@@ -985,6 +1060,7 @@ static HRESULT interp_assign_member(exec_ctx_t *ctx)
     const unsigned arg_cnt = ctx->instr->arg2.uint;
     IDispatch *obj;
     DISPPARAMS dp;
+    BOOL cached;
     DISPID id;
     HRESULT hres;
 
@@ -999,10 +1075,14 @@ static HRESULT interp_assign_member(exec_ctx_t *ctx)
         return E_FAIL;
     }
 
-    hres = disp_get_id(obj, identifier, VBDISP_LET, FALSE, &id);
-    if(SUCCEEDED(hres)) {
-        vbstack_to_dp(ctx, arg_cnt, TRUE, &dp);
+    vbstack_to_dp(ctx, arg_cnt, TRUE, &dp);
+    hres = get_member_id(ctx, obj, identifier, VBDISP_LET, &id, &cached);
+    if(SUCCEEDED(hres))
         hres = disp_propput(ctx->script, obj, id, DISPATCH_PROPERTYPUT, &dp);
+    if(hres == DISP_E_MEMBERNOTFOUND && cached) {
+        hres = refresh_member_id(ctx, obj, identifier, VBDISP_LET, &id);
+        if(SUCCEEDED(hres))
+            hres = disp_propput(ctx->script, obj, id, DISPATCH_PROPERTYPUT, &dp);
     }
     if(FAILED(hres))
         return hres;
@@ -1017,6 +1097,7 @@ static HRESULT interp_set_member(exec_ctx_t *ctx)
     const unsigned arg_cnt = ctx->instr->arg2.uint;
     IDispatch *obj;
     DISPPARAMS dp;
+    BOOL cached;
     DISPID id;
     HRESULT hres;
 
@@ -1035,10 +1116,14 @@ static HRESULT interp_set_member(exec_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(obj, identifier, VBDISP_SET, FALSE, &id);
-    if(SUCCEEDED(hres)) {
-        vbstack_to_dp(ctx, arg_cnt, TRUE, &dp);
+    vbstack_to_dp(ctx, arg_cnt, TRUE, &dp);
+    hres = get_member_id(ctx, obj, identifier, VBDISP_SET, &id, &cached);
+    if(SUCCEEDED(hres))
         hres = disp_propput(ctx->script, obj, id, DISPATCH_PROPERTYPUTREF, &dp);
+    if(hres == DISP_E_MEMBERNOTFOUND && cached) {
+        hres = refresh_member_id(ctx, obj, identifier, VBDISP_SET, &id);
+        if(SUCCEEDED(hres))
+            hres = disp_propput(ctx->script, obj, id, DISPATCH_PROPERTYPUTREF, &dp);
     }
     if(FAILED(hres))
         return hres;
@@ -52,21 +52,31 @@ typedef struct match_state_t {
 typedef BYTE jsbytecode;
 
 typedef struct regexp_t {
+    LONG                ref;
     WORD                flags;         /* flags, see jsapi.h's REG_* defines */
     size_t              parenCount;    /* number of parenthesized submatches */
     size_t              classCount;    /* count [...] bitmaps */
     struct RECharSet    *classList;    /* list of [...] bitmaps */
     const WCHAR         *source;       /* locked source string, sans // */
     DWORD               source_len;
+    const WCHAR         *prefix;       /* literal prefix of every match */
+    DWORD               prefix_len;
+    WCHAR               prefix_chr;
     jsbytecode          program[1];    /* regular expression bytecode */
 } regexp_t;
 
 regexp_t* regexp_new(void*, heap_pool_t*, const WCHAR*, DWORD, WORD, BOOL);
-void regexp_destroy(regexp_t*);
+void regexp_release(regexp_t*);
 HRESULT regexp_execute(regexp_t*, void*, heap_pool_t*, const WCHAR*,
         DWORD, match_state_t*);
 HRESULT regexp_set_flags(regexp_t**, void*, heap_pool_t*, WORD);
 
+static inline regexp_t *regexp_addref(regexp_t *re)
+{
+    re->ref++;
+    return re;
+}
+
 static inline match_state_t* alloc_match_state(regexp_t *regexp,
         heap_pool_t *pool, const WCHAR *pos)
 {
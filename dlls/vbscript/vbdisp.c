@@ -504,6 +504,11 @@ static inline vbdisp_t *unsafe_impl_from_IDispatch(IDispatch *iface)
         : NULL;
 }
 
+BOOL is_vbdisp(IDispatch *disp)
+{
+    return unsafe_impl_from_IDispatch(disp) != NULL;
+}
+
 HRESULT create_vbdisp(const class_desc_t *desc, vbdisp_t **ret)
 {
     vbdisp_t *vbdisp;
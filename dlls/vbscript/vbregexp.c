@@ -1118,7 +1118,7 @@ static ULONG WINAPI RegExp2_Release(IRegExp2 *iface)
     if(!ref) {
         free(This->pattern);
         if(This->regexp)
-            regexp_destroy(This->regexp);
+            regexp_release(This->regexp);
         heap_pool_free(&This->pool);
         free(This);
     }
@@ -1211,7 +1211,7 @@ static HRESULT WINAPI RegExp2_put_Pattern(IRegExp2 *iface, BSTR pattern)
     This->pattern = new_pattern;
 
     if(This->regexp) {
-        regexp_destroy(This->regexp);
+        regexp_release(This->regexp);
         This->regexp = NULL;
     }
     return S_OK;
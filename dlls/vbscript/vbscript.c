@@ -271,6 +271,8 @@ static void release_script(script_ctx_t *ctx)
     named_item_t *item, *item_next;
     vbscode_t *code, *code_next;
 
+    TRACE("member DISPID cache: %u hits, %u misses\n", ctx->member_cache_hits, ctx->member_cache_misses);
+
     collect_objects(ctx);
     clear_ei(&ctx->ei);
 
@@ -161,6 +161,7 @@ typedef struct named_item_t {
 
 HRESULT create_vbdisp(const class_desc_t*,vbdisp_t**);
 HRESULT disp_get_id(IDispatch*,BSTR,vbdisp_invoke_type_t,BOOL,DISPID*);
+BOOL is_vbdisp(IDispatch*);
 HRESULT vbdisp_get_id(vbdisp_t*,BSTR,vbdisp_invoke_type_t,BOOL,DISPID*);
 HRESULT disp_call(script_ctx_t*,IDispatch*,DISPID,DISPPARAMS*,VARIANT*);
 HRESULT disp_propput(script_ctx_t*,IDispatch*,DISPID,WORD,DISPPARAMS*);
@@ -211,6 +212,9 @@ struct _script_ctx_t {
     struct list objects;
     struct list code_list;
     struct list named_items;
+
+    unsigned member_cache_hits;
+    unsigned member_cache_misses;
 };
 
 HRESULT init_global(script_ctx_t*);
@@ -337,6 +341,17 @@ typedef struct {
     const WCHAR *name;
 } var_desc_t;
 
+/*
+ * DISPID of a member of an external object last looked up by a member call
+ * or assignment instruction, for the object at that address.
+ */
+typedef struct {
+    unsigned instr;
+    IDispatch *disp;
+    const void *vtbl;
+    DISPID id;
+} member_cache_entry_t;
+
 struct _function_t {
     function_type_t type;
     const WCHAR *name;
@@ -349,6 +364,8 @@ struct _function_t {
     unsigned array_cnt;
     unsigned code_off;
     vbscode_t *code_ctx;
+    member_cache_entry_t *member_cache; /* sorted by instruction */
+    unsigned member_cache_cnt;
     function_t *next;
 };
 
@@ -23,6 +23,7 @@
 #endif
 
 #include <assert.h>
+#include <pthread.h>
 
 #include "ntgdi_private.h"
 #include "dibdrv.h"
@@ -585,17 +586,194 @@ static void mask_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src,
     }
 }
 
+/* Large blits are split into horizontal stripes that are rendered concurrently by a small
+ * pool of worker threads.  The workers are plain Unix threads, so the stripe callbacks must
+ * only touch pixel data and never call back into Wine. */
+
+#define MAX_STRIPE_THREADS  16
+#define MIN_STRIPE_ROWS     16
+
+struct stripe_job
+{
+    void       (*func)( void *ctx, int stripe );
+    void        *ctx;
+    int          count;  /* total number of stripes */
+    int          next;   /* next stripe to hand out */
+    int          done;   /* number of completed stripes */
+};
+
+static pthread_mutex_t stripe_job_mutex = PTHREAD_MUTEX_INITIALIZER;  /* held by the submitting thread */
+static pthread_mutex_t stripe_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t stripe_work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t stripe_done_cond = PTHREAD_COND_INITIALIZER;
+static struct stripe_job *stripe_job;
+static unsigned int stripe_threads;
+static unsigned int stripe_threshold = 512 * 512;  /* in pixels */
+
+static void *stripe_worker( void *arg )
+{
+    struct stripe_job *job;
+    int stripe;
+
+    pthread_mutex_lock( &stripe_mutex );
+    for (;;)
+    {
+        if (!(job = stripe_job) || job->next >= job->count)
+        {
+            pthread_cond_wait( &stripe_work_cond, &stripe_mutex );
+            continue;
+        }
+        stripe = job->next++;
+        pthread_mutex_unlock( &stripe_mutex );
+        job->func( job->ctx, stripe );
+        pthread_mutex_lock( &stripe_mutex );
+        if (++job->done == job->count) pthread_cond_signal( &stripe_done_cond );
+    }
+    return NULL;
+}
+
+static void init_stripe_threads(void)
+{
+    unsigned int i, count = max( system_info.NumberOfProcessors, 1 ) - 1;
+    pthread_attr_t attr;
+    pthread_t thread;
+
+    count = get_dib_engine_option( "StripeThreads", count );
+    stripe_threshold = get_dib_engine_option( "StripeThreshold", stripe_threshold );
+
+    count = min( count, MAX_STRIPE_THREADS );
+    if (!count || !stripe_threshold) return;
+
+    pthread_attr_init( &attr );
+    pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
+    for (i = 0; i < count; i++)
+        if (pthread_create( &thread, &attr, stripe_worker, NULL )) break;
+    pthread_attr_destroy( &attr );
+    stripe_threads = i;
+
+    TRACE( "using %u stripe threads, threshold %u pixels\n", stripe_threads, stripe_threshold );
+}
+
+/* number of stripes to use for an operation on the given rows, 1 if it should not be split */
+static int get_stripe_count( int width, int height )
+{
+    static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+    int count;
+
+    pthread_once( &init_once, init_stripe_threads );
+    if (!stripe_threads || width <= 0 || height < 2 * MIN_STRIPE_ROWS) return 1;
+    if ((ULONGLONG)width * height < stripe_threshold) return 1;
+    /* a few stripes per thread to even out the load */
+    count = (stripe_threads + 1) * 4;
+    return min( count, height / MIN_STRIPE_ROWS );
+}
+
+/* call func for each stripe, using the worker threads when they are available */
+static void run_stripes( int count, void (*func)( void *ctx, int stripe ), void *ctx )
+{
+    struct stripe_job job = { func, ctx, count };
+    int stripe;
+
+    if (count <= 1 || pthread_mutex_trylock( &stripe_job_mutex ))
+    {
+        /* the pool is busy with another DC, render in the calling thread */
+        for (stripe = 0; stripe < count; stripe++) func( ctx, stripe );
+        return;
+    }
+
+    pthread_mutex_lock( &stripe_mutex );
+    stripe_job = &job;
+    pthread_cond_broadcast( &stripe_work_cond );
+    while (job.next < job.count)
+    {
+        stripe = job.next++;
+        pthread_mutex_unlock( &stripe_mutex );
+        func( ctx, stripe );
+        pthread_mutex_lock( &stripe_mutex );
+        job.done++;
+    }
+    while (job.done < job.count) pthread_cond_wait( &stripe_done_cond, &stripe_mutex );
+    stripe_job = NULL;
+    pthread_mutex_unlock( &stripe_mutex );
+    pthread_mutex_unlock( &stripe_job_mutex );
+}
+
+/* rectangles covering the rows [top, bottom) split into stripes */
+struct striped_rects
+{
+    const RECT *rects;
+    int         count;
+    int         top;
+    int         rows;   /* rows per stripe */
+};
+
+static void init_striped_rects( struct striped_rects *striped, const struct clipped_rects *clipped_rects,
+                                int *stripes )
+{
+    RECT bounds = clipped_rects->rects[0];
+    int i;
+
+    for (i = 1; i < clipped_rects->count; i++) union_rect( &bounds, &bounds, &clipped_rects->rects[i] );
+
+    striped->rects = clipped_rects->rects;
+    striped->count = clipped_rects->count;
+    striped->top   = bounds.top;
+    *stripes = get_stripe_count( bounds.right - bounds.left, bounds.bottom - bounds.top );
+    striped->rows  = (bounds.bottom - bounds.top + *stripes - 1) / *stripes;
+}
+
+/* retrieve the intersection of a rectangle with a stripe, return FALSE if empty */
+static BOOL get_stripe_rect( const struct striped_rects *striped, int stripe, int i, RECT *rc )
+{
+    *rc = striped->rects[i];
+    rc->top    = max( rc->top, striped->top + stripe * striped->rows );
+    rc->bottom = min( rc->bottom, striped->top + (stripe + 1) * striped->rows );
+    return rc->top < rc->bottom;
+}
+
+struct blend_stripes
+{
+    struct striped_rects striped;
+    const dib_info      *dst;
+    const dib_info      *src;
+    POINT                offset;
+    BLENDFUNCTION        blend;
+};
+
+static void blend_stripe( void *ctx, int stripe )
+{
+    const struct blend_stripes *params = ctx;
+    RECT rc;
+    int i;
+
+    for (i = 0; i < params->striped.count; i++)
+        if (get_stripe_rect( &params->striped, stripe, i, &rc ))
+            params->dst->funcs->blend_rects( params->dst, 1, &rc, params->src, &params->offset, params->blend );
+}
+
 static DWORD blend_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src, const RECT *src_rect,
                          HRGN clip, BLENDFUNCTION blend )
 {
     POINT offset;
     struct clipped_rects clipped_rects;
+    struct blend_stripes params;
+    int stripes;
 
     if (!get_clipped_rects( dst, dst_rect, clip, &clipped_rects )) return ERROR_SUCCESS;
 
     offset.x = src_rect->left - dst_rect->left;
     offset.y = src_rect->top  - dst_rect->top;
-    dst->funcs->blend_rects( dst, clipped_rects.count, clipped_rects.rects, src, &offset, blend );
+
+    init_striped_rects( &params.striped, &clipped_rects, &stripes );
+    if (stripes > 1)
+    {
+        params.dst    = dst;
+        params.src    = src;
+        params.offset = offset;
+        params.blend  = blend;
+        run_stripes( stripes, blend_stripe, &params );
+    }
+    else dst->funcs->blend_rects( dst, clipped_rects.count, clipped_rects.rects, src, &offset, blend );
 
     free_clipped_rects( &clipped_rects );
     return ERROR_SUCCESS;
@@ -680,14 +858,50 @@ static void get_gradient_triangle_vertices( const GRADIENT_TRIANGLE *tri, const
     bounds->bottom = v[2].y;
 }
 
-static BOOL gradient_rect( dib_info *dib, TRIVERTEX *v, int mode, HRGN clip, const RECT *bounds )
+struct gradient_stripes
+{
+    struct striped_rects striped;
+    const dib_info      *dib;
+    const TRIVERTEX     *v;
+    int                  mode;
+    LONG                 failed;
+};
+
+static void gradient_stripe( void *ctx, int stripe )
 {
+    struct gradient_stripes *params = ctx;
+    RECT rc;
     int i;
+
+    for (i = 0; i < params->striped.count; i++)
+    {
+        if (!get_stripe_rect( &params->striped, stripe, i, &rc )) continue;
+        if (params->dib->funcs->gradient_rect( params->dib, &rc, params->v, params->mode )) continue;
+        InterlockedExchange( &params->failed, 1 );
+        break;
+    }
+}
+
+static BOOL gradient_rect( dib_info *dib, TRIVERTEX *v, int mode, HRGN clip, const RECT *bounds )
+{
+    int i, stripes;
     struct clipped_rects clipped_rects;
+    struct gradient_stripes params;
     BOOL ret = TRUE;
 
     if (!get_clipped_rects( dib, bounds, clip, &clipped_rects )) return TRUE;
-    for (i = 0; i < clipped_rects.count; i++)
+
+    init_striped_rects( &params.striped, &clipped_rects, &stripes );
+    if (stripes > 1)
+    {
+        params.dib    = dib;
+        params.v      = v;
+        params.mode   = mode;
+        params.failed = 0;
+        run_stripes( stripes, gradient_stripe, &params );
+        ret = !params.failed;
+    }
+    else for (i = 0; i < clipped_rects.count; i++)
     {
         if (!(ret = dib->funcs->gradient_rect( dib, &clipped_rects.rects[i], v, mode ))) break;
     }
@@ -1198,117 +1412,203 @@ static DWORD calc_1d_stretch_params( INT dst_start, INT dst_length, INT dst_vis_
 }
 
 
-DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bitblt_coords *src,
-                          const BITMAPINFO *dst_info, void *dst_bits, struct bitblt_coords *dst,
-                          INT mode )
+/* state of the vertical stretch loop at the start of a destination row */
+struct stretch_rows_state
 {
-    dib_info src_dib, dst_dib;
-    POINT dst_start, src_start, dst_end, src_end;
-    RECT rect;
-    BOOL hstretch, vstretch;
-    struct stretch_params v_params, h_params;
-    int err;
-    DWORD ret;
-    void (* row_fn)(const dib_info *dst_dib, const POINT *dst_start,
-                    const dib_info *src_dib, const POINT *src_start,
-                    const struct stretch_params *params, int mode, BOOL keep_dst);
+    POINT        dst_start;
+    POINT        src_start;
+    int          err;
+    unsigned int length;  /* remaining iterations */
+};
 
-    TRACE("dst %d, %d - %d x %d visrect %s src %d, %d - %d x %d visrect %s\n",
-          dst->x, dst->y, dst->width, dst->height, wine_dbgstr_rect(&dst->visrect),
-          src->x, src->y, src->width, src->height, wine_dbgstr_rect(&src->visrect));
+struct stretch_rows_params
+{
+    dib_info                   *dst_dib;
+    const dib_info             *src_dib;
+    struct stretch_params       v_params;
+    struct stretch_params       h_params;
+    BOOL                        vstretch;
+    int                         mode;
+    int                         width;
+    void                      (*row_fn)( const dib_info *dst_dib, const POINT *dst_start,
+                                         const dib_info *src_dib, const POINT *src_start,
+                                         const struct stretch_params *params, int mode, BOOL keep_dst );
+    struct stretch_rows_state  *stripes;
+};
 
-    init_dib_info_from_bitmapinfo( &src_dib, src_info, src_bits );
-    init_dib_info_from_bitmapinfo( &dst_dib, dst_info, dst_bits );
+/* advance the vertical stretch state by one iteration, return TRUE if a new destination row starts */
+static BOOL next_stretch_row( const struct stretch_rows_params *params, struct stretch_rows_state *state )
+{
+    BOOL new_row;
 
-    if (mode == HALFTONE)
+    state->length--;
+    if (params->vstretch)
     {
-        dst_dib.funcs->halftone( &dst_dib, dst, &src_dib, src );
-        goto done;
+        if (state->err > 0)
+        {
+            state->src_start.y += params->v_params.src_inc;
+            state->err += params->v_params.err_add_1;
+        }
+        else state->err += params->v_params.err_add_2;
+        state->dst_start.y += params->v_params.dst_inc;
+        return TRUE;
     }
 
-    /* v */
-    ret = calc_1d_stretch_params( dst->y, dst->height, dst->visrect.top, dst->visrect.bottom,
-                                  src->y, src->height, src->visrect.top, src->visrect.bottom,
-                                  &dst_start.y, &src_start.y, &dst_end.y, &src_end.y,
-                                  &v_params, &vstretch );
-    if (ret) return ret;
-
-    /* h */
-    ret = calc_1d_stretch_params( dst->x, dst->width, dst->visrect.left, dst->visrect.right,
-                                  src->x, src->width, src->visrect.left, src->visrect.right,
-                                  &dst_start.x, &src_start.x, &dst_end.x, &src_end.x,
-                                  &h_params, &hstretch );
-    if (ret) return ret;
-
-    TRACE("got dst start %d, %d inc %d, %d. src start %d, %d inc %d, %d len %d x %d\n",
-          (int)dst_start.x, (int)dst_start.y, h_params.dst_inc, v_params.dst_inc,
-          (int)src_start.x, (int)src_start.y, h_params.src_inc, v_params.src_inc,
-          h_params.length, v_params.length);
-
-    get_bounding_rect( &rect, dst_start.x, dst_start.y, dst_end.x - dst_start.x, dst_end.y - dst_start.y );
-    intersect_rect( &dst->visrect, &dst->visrect, &rect );
-
-    dst_start.x -= dst->visrect.left;
-    dst_start.y -= dst->visrect.top;
-
-    err = v_params.err_start;
+    if ((new_row = state->err > 0))
+    {
+        state->dst_start.y += params->v_params.dst_inc;
+        state->err += params->v_params.err_add_1;
+    }
+    else state->err += params->v_params.err_add_2;
+    state->src_start.y += params->v_params.src_inc;
+    return new_row;
+}
 
-    row_fn = hstretch ? dst_dib.funcs->stretch_row : dst_dib.funcs->shrink_row;
+static void stretch_rows( const struct stretch_rows_params *params, struct stretch_rows_state state, unsigned int count )
+{
+    dib_info *dst_dib = params->dst_dib;
+    int mode = params->mode;
 
-    if (vstretch)
+    if (params->vstretch)
     {
         BOOL need_row = TRUE;
         RECT last_row, this_row;
-        if (hstretch) mode = STRETCH_DELETESCANS;
         last_row.left = 0;
-        last_row.right = dst->visrect.right - dst->visrect.left;
+        last_row.right = params->width;
 
-        while (v_params.length--)
+        while (count--)
         {
             if (need_row)
             {
-                row_fn( &dst_dib, &dst_start, &src_dib, &src_start, &h_params, mode, FALSE );
+                params->row_fn( dst_dib, &state.dst_start, params->src_dib, &state.src_start,
+                                &params->h_params, mode, FALSE );
                 need_row = FALSE;
             }
             else
             {
-                last_row.top = dst_start.y - v_params.dst_inc;
+                last_row.top = state.dst_start.y - params->v_params.dst_inc;
                 last_row.bottom = last_row.top + 1;
                 this_row = last_row;
-                OffsetRect( &this_row, 0, v_params.dst_inc );
-                copy_rect( &dst_dib, &this_row, &dst_dib, &last_row, NULL, R2_COPYPEN );
+                OffsetRect( &this_row, 0, params->v_params.dst_inc );
+                copy_rect( dst_dib, &this_row, dst_dib, &last_row, NULL, R2_COPYPEN );
             }
 
-            if (err > 0)
-            {
-                src_start.y += v_params.src_inc;
-                need_row = TRUE;
-                err += v_params.err_add_1;
-            }
-            else err += v_params.err_add_2;
-            dst_start.y += v_params.dst_inc;
+            if (state.err > 0) need_row = TRUE;
+            next_stretch_row( params, &state );
         }
     }
     else
     {
         int merged_rows = 0;
 
-        while (v_params.length--)
+        while (count--)
         {
             if (mode != STRETCH_DELETESCANS || !merged_rows)
-                row_fn( &dst_dib, &dst_start, &src_dib, &src_start, &h_params, mode, merged_rows != 0 );
+                params->row_fn( dst_dib, &state.dst_start, params->src_dib, &state.src_start,
+                                &params->h_params, mode, merged_rows != 0 );
             merged_rows++;
-
-            if (err > 0)
-            {
-                dst_start.y += v_params.dst_inc;
-                merged_rows = 0;
-                err += v_params.err_add_1;
-            }
-            else err += v_params.err_add_2;
-            src_start.y += v_params.src_inc;
+            if (next_stretch_row( params, &state )) merged_rows = 0;
         }
     }
+}
+
+static void stretch_stripe( void *ctx, int stripe )
+{
+    const struct stretch_rows_params *params = ctx;
+
+    stretch_rows( params, params->stripes[stripe],
+                  params->stripes[stripe].length - params->stripes[stripe + 1].length );
+}
+
+/* split the stretch into stripes starting on destination row boundaries, return the stripe count */
+static int init_stretch_stripes( struct stretch_rows_params *params, const struct stretch_rows_state *start,
+                                 int height )
+{
+    struct stretch_rows_state state = *start;
+    int count = get_stripe_count( params->width, height ), rows = 0, stripe = 0, rows_per_stripe;
+
+    if (count <= 1 || !(params->stripes = malloc( (count + 1) * sizeof(*params->stripes) ))) return 1;
+
+    rows_per_stripe = (height + count - 1) / count;
+    params->stripes[stripe++] = state;
+    while (state.length)
+    {
+        if (!next_stretch_row( params, &state )) continue;
+        if (++rows < rows_per_stripe || !state.length) continue;
+        params->stripes[stripe++] = state;
+        rows = 0;
+        if (stripe == count) break;
+    }
+    state.length = 0;
+    params->stripes[stripe] = state;
+    return stripe;
+}
+
+DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bitblt_coords *src,
+                          const BITMAPINFO *dst_info, void *dst_bits, struct bitblt_coords *dst,
+                          INT mode )
+{
+    dib_info src_dib, dst_dib;
+    POINT dst_end, src_end;
+    RECT rect;
+    BOOL hstretch;
+    struct stretch_rows_params params;
+    struct stretch_rows_state state;
+    int stripes;
+    DWORD ret;
+
+    TRACE("dst %d, %d - %d x %d visrect %s src %d, %d - %d x %d visrect %s\n",
+          dst->x, dst->y, dst->width, dst->height, wine_dbgstr_rect(&dst->visrect),
+          src->x, src->y, src->width, src->height, wine_dbgstr_rect(&src->visrect));
+
+    init_dib_info_from_bitmapinfo( &src_dib, src_info, src_bits );
+    init_dib_info_from_bitmapinfo( &dst_dib, dst_info, dst_bits );
+
+    if (mode == HALFTONE)
+    {
+        dst_dib.funcs->halftone( &dst_dib, dst, &src_dib, src );
+        goto done;
+    }
+
+    /* v */
+    ret = calc_1d_stretch_params( dst->y, dst->height, dst->visrect.top, dst->visrect.bottom,
+                                  src->y, src->height, src->visrect.top, src->visrect.bottom,
+                                  &state.dst_start.y, &state.src_start.y, &dst_end.y, &src_end.y,
+                                  &params.v_params, &params.vstretch );
+    if (ret) return ret;
+
+    /* h */
+    ret = calc_1d_stretch_params( dst->x, dst->width, dst->visrect.left, dst->visrect.right,
+                                  src->x, src->width, src->visrect.left, src->visrect.right,
+                                  &state.dst_start.x, &state.src_start.x, &dst_end.x, &src_end.x,
+                                  &params.h_params, &hstretch );
+    if (ret) return ret;
+
+    TRACE("got dst start %d, %d inc %d, %d. src start %d, %d inc %d, %d len %d x %d\n",
+          (int)state.dst_start.x, (int)state.dst_start.y, params.h_params.dst_inc, params.v_params.dst_inc,
+          (int)state.src_start.x, (int)state.src_start.y, params.h_params.src_inc, params.v_params.src_inc,
+          params.h_params.length, params.v_params.length);
+
+    get_bounding_rect( &rect, state.dst_start.x, state.dst_start.y,
+                       dst_end.x - state.dst_start.x, dst_end.y - state.dst_start.y );
+    intersect_rect( &dst->visrect, &dst->visrect, &rect );
+
+    state.dst_start.x -= dst->visrect.left;
+    state.dst_start.y -= dst->visrect.top;
+    state.err = params.v_params.err_start;
+    state.length = params.v_params.length;
+
+    params.dst_dib = &dst_dib;
+    params.src_dib = &src_dib;
+    params.row_fn  = hstretch ? dst_dib.funcs->stretch_row : dst_dib.funcs->shrink_row;
+    params.mode    = (params.vstretch && hstretch) ? STRETCH_DELETESCANS : mode;
+    params.width   = dst->visrect.right - dst->visrect.left;
+    params.stripes = NULL;
+
+    stripes = init_stretch_stripes( &params, &state, dst->visrect.bottom - dst->visrect.top );
+    if (stripes > 1) run_stripes( stripes, stretch_stripe, &params );
+    else stretch_rows( &params, state, state.length );
+    free( params.stripes );
 
 done:
     /* update coordinates, the destination rectangle is always stored at 0,0 */
@@ -39,6 +39,21 @@ static const struct osmesa_funcs *osmesa_funcs;
 static const DWORD bit_fields_888[3] = {0xff0000, 0x00ff00, 0x0000ff};
 static const DWORD bit_fields_555[3] = {0x7c00, 0x03e0, 0x001f};
 
+/* retrieve a DWORD tuning option, returns def if it isn't set */
+DWORD get_dib_engine_option( const char *name, DWORD def )
+{
+    char buffer[offsetof(KEY_VALUE_PARTIAL_INFORMATION, Data[sizeof(DWORD)])];
+    KEY_VALUE_PARTIAL_INFORMATION *value = (void *)buffer;
+    HKEY hkey;
+
+    /* @@ Wine registry key: HKCU\Software\Wine\DIB Engine */
+    if (!(hkey = reg_open_hkcu_key( "Software\\Wine\\DIB Engine" ))) return def;
+    if (query_reg_ascii_value( hkey, name, value, sizeof(buffer) ) && value->Type == REG_DWORD)
+        def = *(const DWORD *)value->Data;
+    NtClose( hkey );
+    return def;
+}
+
 static void calc_shift_and_len(DWORD mask, int *shift, int *len)
 {
     int s, l;
@@ -730,6 +745,7 @@ struct windrv_physdev
     struct gdi_physdev     dev;
     struct dibdrv_physdev *dibdrv;
     struct window_surface *surface;
+    RECT                   bounds;  /* bounds of the current operation, if the surface tracks them */
 };
 
 static const struct gdi_dc_funcs window_driver;
@@ -743,13 +759,18 @@ static inline void lock_surface( struct windrv_physdev *dev )
 {
     /* gdi_lock should not be locked */
     dev->surface->funcs->lock( dev->surface );
-    if (IsRectEmpty( dev->dibdrv->bounds ) || dev->surface->draw_start_ticks == 0)
+    if (IsRectEmpty( dev->surface->funcs->get_bounds( dev->surface )) || dev->surface->draw_start_ticks == 0)
         dev->surface->draw_start_ticks = NtGetTickCount();
+    if (dev->surface->funcs->add_bounds) reset_bounds( &dev->bounds );
 }
 
 static inline void unlock_surface( struct windrv_physdev *dev )
 {
     BOOL should_flush = NtGetTickCount() - dev->surface->draw_start_ticks > FLUSH_PERIOD;
+
+    /* let the surface see each damaged rectangle instead of only their union */
+    if (dev->surface->funcs->add_bounds && !IsRectEmpty( &dev->bounds ))
+        dev->surface->funcs->add_bounds( dev->surface, &dev->bounds );
     dev->surface->funcs->unlock( dev->surface );
     if (should_flush) dev->surface->funcs->flush( dev->surface );
 }
@@ -792,7 +813,8 @@ void dibdrv_set_window_surface( DC *dc, struct window_surface *surface )
         init_dib_info_from_bitmapinfo( &dibdrv->dib, info, bits );
         dibdrv->dib.rect = dc->attr->vis_rect;
         OffsetRect( &dibdrv->dib.rect, -dc->device_rect.left, -dc->device_rect.top );
-        dibdrv->bounds = surface->funcs->get_bounds( surface );
+        if (surface->funcs->add_bounds) dibdrv->bounds = &physdev->bounds;
+        else dibdrv->bounds = surface->funcs->get_bounds( surface );
         DC_InitDC( dc );
     }
     else if (windev)
@@ -247,6 +247,7 @@ struct clipped_rects
     RECT  buffer[32];
 };
 
+extern DWORD get_dib_engine_option( const char *name, DWORD def ) DECLSPEC_HIDDEN;
 extern void get_rop_codes(INT rop, struct rop_codes *codes) DECLSPEC_HIDDEN;
 extern void reset_dash_origin(dibdrv_physdev *pdev) DECLSPEC_HIDDEN;
 extern void init_dib_info_from_bitmapinfo(dib_info *dib, const BITMAPINFO *info, void *bits) DECLSPEC_HIDDEN;
@@ -49,19 +49,39 @@ enum glyph_type
 
 struct cached_font
 {
-    struct list           entry;
+    struct list           entry;       /* entry in LRU list */
+    struct list           hash_entry;  /* entry in hash bucket */
     LONG                  ref;
     DWORD                 hash;
     LOGFONTW              lf;
     XFORM                 xform;
     UINT                  aa_flags;
+    LONG                  size;        /* memory used by the font and its glyphs */
     struct cached_glyph **glyphs[GLYPH_NBTYPES][GLYPH_CACHE_PAGES];
 };
 
+#define FONT_CACHE_BUCKETS  64
+#define FONT_CACHE_MIN_FONTS 5      /* keep at least that many unused fonts around */
+
 static struct list font_cache = LIST_INIT( font_cache );
+static struct list font_cache_buckets[FONT_CACHE_BUCKETS];
+static LONG font_cache_size;  /* total memory used by cached fonts */
+static LONG font_cache_max_size = 4 * 1024 * 1024;
+
+/* statistics, dumped on the glyphcache channel */
+static struct
+{
+    LONG font_hits;
+    LONG font_misses;
+    LONG font_evictions;
+    LONG glyph_hits;
+    LONG glyph_misses;
+} font_cache_stats;
 
 static pthread_mutex_t font_cache_lock = PTHREAD_MUTEX_INITIALIZER;
 
+WINE_DECLARE_DEBUG_CHANNEL(glyphcache);
+
 
 static BOOL brush_rect( dibdrv_physdev *pdev, dib_brush *brush, const RECT *rect, HRGN clip )
 {
@@ -551,10 +571,69 @@ static int font_cache_cmp( const struct cached_font *p1, const struct cached_fon
     return ret;
 }
 
+static void dump_font_cache_stats(void)
+{
+    TRACE_(glyphcache)( "fonts: %d hits %d misses %d evictions, glyphs: %d hits %d misses, "
+                        "%d/%d bytes used\n",
+                        (int)font_cache_stats.font_hits, (int)font_cache_stats.font_misses,
+                        (int)font_cache_stats.font_evictions, (int)font_cache_stats.glyph_hits,
+                        (int)font_cache_stats.glyph_misses, (int)font_cache_size, (int)font_cache_max_size );
+}
+
+static void init_font_cache(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < FONT_CACHE_BUCKETS; i++) list_init( &font_cache_buckets[i] );
+    /* leave headroom so that font_cache_size can't overflow either */
+    font_cache_max_size = min( get_dib_engine_option( "GlyphCacheSize", font_cache_max_size ), MAXLONG / 2 );
+}
+
+static void free_cached_font( struct cached_font *font )
+{
+    UINT i, j, k;
+
+    for (i = 0; i < GLYPH_NBTYPES; i++)
+    {
+        for (j = 0; j < GLYPH_CACHE_PAGES; j++)
+        {
+            if (!font->glyphs[i][j]) continue;
+            for (k = 0; k < GLYPH_CACHE_PAGE_SIZE; k++)
+                free( font->glyphs[i][j][k] );
+            free( font->glyphs[i][j] );
+        }
+    }
+    list_remove( &font->entry );
+    list_remove( &font->hash_entry );
+    InterlockedExchangeAdd( &font_cache_size, -font->size );
+    free( font );
+}
+
+/* free least recently used fonts until the cache fits in its budget; font_cache_lock must be held */
+static void trim_font_cache(void)
+{
+    struct cached_font *font, *next;
+    unsigned int unused = 0;
+
+    LIST_FOR_EACH_ENTRY( font, &font_cache, struct cached_font, entry )
+        if (!font->ref) unused++;
+
+    LIST_FOR_EACH_ENTRY_SAFE_REV( font, next, &font_cache, struct cached_font, entry )
+    {
+        if (font_cache_size <= font_cache_max_size || unused <= FONT_CACHE_MIN_FONTS) break;
+        if (font->ref) continue;
+        TRACE( "freeing %p, %d bytes\n", font, (int)font->size );
+        free_cached_font( font );
+        font_cache_stats.font_evictions++;
+        unused--;
+    }
+}
+
 static struct cached_font *add_cached_font( DC *dc, HFONT hfont, UINT aa_flags )
 {
-    struct cached_font font, *ptr, *last_unused = NULL;
-    UINT i = 0, j, k;
+    static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+    struct cached_font font, *ptr;
+    struct list *bucket;
 
     NtGdiExtGetObjectW( hfont, sizeof(font.lf), &font.lf );
     font.xform = dc->xformWorld2Vport;
@@ -569,38 +648,25 @@ static struct cached_font *add_cached_font( DC *dc, HFONT hfont, UINT aa_flags )
     font.aa_flags = aa_flags;
     font.hash = font_cache_hash( &font );
 
+    pthread_once( &init_once, init_font_cache );
+    bucket = &font_cache_buckets[font.hash % FONT_CACHE_BUCKETS];
+
     pthread_mutex_lock( &font_cache_lock );
-    LIST_FOR_EACH_ENTRY( ptr, &font_cache, struct cached_font, entry )
+    LIST_FOR_EACH_ENTRY( ptr, bucket, struct cached_font, hash_entry )
     {
         if (!font_cache_cmp( &font, ptr ))
         {
             InterlockedIncrement( &ptr->ref );
             list_remove( &ptr->entry );
+            font_cache_stats.font_hits++;
             goto done;
         }
-        if (!ptr->ref)
-        {
-            i++;
-            last_unused = ptr;
-        }
     }
 
-    if (i > 5)  /* keep at least 5 of the most-recently used fonts around */
-    {
-        ptr = last_unused;
-        for (i = 0; i < GLYPH_NBTYPES; i++)
-        {
-            for (j = 0; j < GLYPH_CACHE_PAGES; j++)
-            {
-                if (!ptr->glyphs[i][j]) continue;
-                for (k = 0; k < GLYPH_CACHE_PAGE_SIZE; k++)
-                    free( ptr->glyphs[i][j][k] );
-                free( ptr->glyphs[i][j] );
-            }
-        }
-        list_remove( &ptr->entry );
-    }
-    else if (!(ptr = malloc( sizeof(*ptr) )))
+    font_cache_stats.font_misses++;
+    trim_font_cache();
+
+    if (!(ptr = malloc( sizeof(*ptr) )))
     {
         pthread_mutex_unlock( &font_cache_lock );
         return NULL;
@@ -608,7 +674,11 @@ static struct cached_font *add_cached_font( DC *dc, HFONT hfont, UINT aa_flags )
 
     *ptr = font;
     ptr->ref = 1;
+    ptr->size = sizeof(*ptr);
     memset( ptr->glyphs, 0, sizeof(ptr->glyphs) );
+    list_add_head( bucket, &ptr->hash_entry );
+    InterlockedExchangeAdd( &font_cache_size, ptr->size );
+    if (TRACE_ON(glyphcache)) dump_font_cache_stats();
 done:
     list_add_head( &font_cache, &ptr->entry );
     pthread_mutex_unlock( &font_cache_lock );
@@ -616,13 +686,22 @@ done:
     return ptr;
 }
 
+/* enforce the cache budget once it has been exceeded by glyphs added to fonts in use */
+static void check_font_cache_size(void)
+{
+    if (font_cache_size <= font_cache_max_size) return;
+    pthread_mutex_lock( &font_cache_lock );
+    trim_font_cache();
+    pthread_mutex_unlock( &font_cache_lock );
+}
+
 void release_cached_font( struct cached_font *font )
 {
-    if (font) InterlockedDecrement( &font->ref );
+    if (font && !InterlockedDecrement( &font->ref )) check_font_cache_size();
 }
 
 static struct cached_glyph *add_cached_glyph( struct cached_font *font, UINT index, UINT flags,
-                                              struct cached_glyph *glyph )
+                                              struct cached_glyph *glyph, UINT size )
 {
     struct cached_glyph *ret;
     enum glyph_type type = (flags & ETO_GLYPH_INDEX) ? GLYPH_INDEX : GLYPH_WCHAR;
@@ -641,9 +720,20 @@ static struct cached_glyph *add_cached_glyph( struct cached_font *font, UINT ind
         }
         if (InterlockedCompareExchangePointer( (void **)&font->glyphs[type][page], ptr, NULL ))
             free( ptr );
+        else
+        {
+            InterlockedExchangeAdd( &font->size, GLYPH_CACHE_PAGE_SIZE * sizeof(*ptr) );
+            InterlockedExchangeAdd( &font_cache_size, GLYPH_CACHE_PAGE_SIZE * sizeof(*ptr) );
+        }
     }
     ret = InterlockedCompareExchangePointer( (void **)&font->glyphs[type][page][entry], glyph, NULL );
-    if (!ret) ret = glyph;
+    if (!ret)
+    {
+        InterlockedExchangeAdd( &font->size, size );
+        InterlockedExchangeAdd( &font_cache_size, size );
+        ret = glyph;
+        check_font_cache_size();
+    }
     else free( glyph );
     return ret;
 }
@@ -804,14 +894,14 @@ static struct cached_glyph *cache_glyph_bitmap( DC *dc, struct cached_font *font
 
 done:
     glyph->metrics = metrics;
-    return add_cached_glyph( font, index, flags, glyph );
+    return add_cached_glyph( font, index, flags, glyph, FIELD_OFFSET( struct cached_glyph, bits[size] ));
 }
 
 static void render_string( DC *dc, dib_info *dib, struct cached_font *font, INT x, INT y,
                            UINT flags, const WCHAR *str, UINT count, const INT *dx,
                            const struct clipped_rects *clipped_rects, RECT *bounds )
 {
-    UINT i;
+    UINT i, misses = 0;
     struct cached_glyph *glyph;
     dib_info glyph_dib;
     DWORD text_color;
@@ -832,8 +922,11 @@ static void render_string( DC *dc, dib_info *dib, struct cached_font *font, INT
 
     for (i = 0; i < count; i++)
     {
-        if (!(glyph = get_cached_glyph( font, str[i], flags )) &&
-            !(glyph = cache_glyph_bitmap( dc, font, str[i], flags ))) continue;
+        if (!(glyph = get_cached_glyph( font, str[i], flags )))
+        {
+            misses++;
+            if (!(glyph = cache_glyph_bitmap( dc, font, str[i], flags ))) continue;
+        }
 
         glyph_dib.width       = glyph->metrics.gmBlackBoxX;
         glyph_dib.height      = glyph->metrics.gmBlackBoxY;
@@ -860,6 +953,9 @@ static void render_string( DC *dc, dib_info *dib, struct cached_font *font, INT
             y += glyph->metrics.gmCellIncY;
         }
     }
+
+    InterlockedExchangeAdd( &font_cache_stats.glyph_hits, count - misses );
+    if (misses) InterlockedExchangeAdd( &font_cache_stats.glyph_misses, misses );
 }
 
 BOOL render_aa_text_bitmapinfo( DC *dc, BITMAPINFO *info, struct gdi_image_bits *bits,
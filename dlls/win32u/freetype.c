@@ -1292,40 +1292,6 @@ static void unix_face_destroy( struct unix_face *This )
     free( This );
 }
 
-static int add_unix_face( const char *unix_name, const WCHAR *file, void *data_ptr, SIZE_T data_size,
-                          DWORD face_index, DWORD flags, DWORD *num_faces )
-{
-    struct unix_face *unix_face;
-    int ret;
-
-    if (num_faces) *num_faces = 0;
-
-    if (!(unix_face = unix_face_create( unix_name, data_ptr, data_size, face_index, flags )))
-        return 0;
-
-    if (unix_face->family_name[0] == '.') /* Ignore fonts with names beginning with a dot */
-    {
-        TRACE("Ignoring %s since its family name begins with a dot\n", debugstr_a(unix_name));
-        unix_face_destroy( unix_face );
-        return 0;
-    }
-
-    if (!HIWORD( flags )) flags |= ADDFONT_AA_FLAGS( default_aa_flags );
-
-    ret = add_gdi_face( unix_face->family_name, unix_face->second_name, unix_face->style_name, unix_face->full_name,
-                        file, data_ptr, data_size, face_index, unix_face->fs, unix_face->ntm_flags,
-                        unix_face->font_version, flags, unix_face->scalable ? NULL : &unix_face->size );
-
-    TRACE("fsCsb = %08x %08x/%08x %08x %08x %08x\n",
-          (int)unix_face->fs.fsCsb[0], (int)unix_face->fs.fsCsb[1],
-          (int)unix_face->fs.fsUsb[0], (int)unix_face->fs.fsUsb[1],
-          (int)unix_face->fs.fsUsb[2], (int)unix_face->fs.fsUsb[3]);
-
-    if (num_faces) *num_faces = unix_face->num_faces;
-    unix_face_destroy( unix_face );
-    return ret;
-}
-
 static WCHAR *get_dos_file_name( LPCSTR str )
 {
     WCHAR *buffer;
@@ -1367,6 +1333,417 @@ static char *get_unix_file_name( LPCWSTR path )
     return buffer;
 }
 
+/* font index
+ *
+ * The properties of the faces found in font files are stored in a binary index shared
+ * by all processes, so that only new or modified files need to be parsed at startup.
+ * The index is rebuilt by the first process that finds it out of date. */
+
+#define FONT_INDEX_MAGIC    0x58444e46  /* "FNDX" */
+#define FONT_INDEX_VERSION  2
+
+#define FONT_INDEX_INVALID       0x01  /* the face could not be loaded */
+#define FONT_INDEX_SCALABLE      0x02
+#define FONT_INDEX_ALLOW_BITMAP  0x04  /* the face was loaded with ADDFONT_ALLOW_BITMAP */
+
+struct font_index_header
+{
+    DWORD magic;
+    DWORD version;
+    DWORD lcid;       /* system lcid used to select the names */
+    DWORD count;      /* number of entries, sorted by file name, flags and face index */
+    DWORD size;       /* total size of the index */
+    DWORD reserved;   /* keeps the entries 8-byte aligned */
+};
+
+struct font_index_entry
+{
+    ULONGLONG               mtime;
+    ULONGLONG               file_size;
+    DWORD                   file;          /* offset of the unix file name */
+    DWORD                   face_index;
+    DWORD                   flags;
+    DWORD                   num_faces;
+    DWORD                   ntm_flags;
+    DWORD                   font_version;
+    FONTSIGNATURE           fs;
+    struct bitmap_font_size size;
+    DWORD                   names[4];      /* offsets of family, second, style and full names, or 0 */
+};
+
+C_ASSERT( !(sizeof(struct font_index_header) % 8) );
+
+struct font_index_record
+{
+    char                   *file;
+    struct font_index_entry entry;
+    WCHAR                  *names[4];
+};
+
+static const struct font_index_header *font_index;
+static char *font_index_path;
+static BOOL font_index_init_done;
+static BOOL font_index_dirty;
+static struct font_index_record *font_index_records;  /* faces seen while loading the system fonts */
+static unsigned int font_index_record_count, font_index_record_size;
+
+static const char *get_font_index_string( DWORD offset )
+{
+    if (!offset || offset >= font_index->size) return NULL;
+    return (const char *)font_index + offset;
+}
+
+/* check that all the strings referenced by the index are terminated within the mapping */
+static BOOL validate_font_index( const struct font_index_header *header )
+{
+    const struct font_index_entry *entries = (const struct font_index_entry *)(header + 1);
+    const char *base = (const char *)header;
+    const WCHAR *name, *end;
+    DWORD i, j, offset;
+
+    for (i = 0; i < header->count; i++)
+    {
+        offset = entries[i].file;
+        if (!offset || offset >= header->size || !memchr( base + offset, 0, header->size - offset ))
+            return FALSE;
+        for (j = 0; j < 4; j++)
+        {
+            if (!(offset = entries[i].names[j])) continue;
+            if (offset >= header->size || (offset & 1)) return FALSE;
+            name = (const WCHAR *)(base + offset);
+            end = (const WCHAR *)(base + (header->size & ~1));
+            while (name < end && *name) name++;
+            if (name == end) return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static void open_font_index(void)
+{
+    static const WCHAR nameW[] = {'\\','?','?','\\','C',':','\\','w','i','n','d','o','w','s','\\',
+        's','y','s','t','e','m','3','2','\\','f','n','t','c','a','c','h','e','.','d','a','t',0};
+    const struct font_index_header *header;
+    struct stat st;
+    int fd;
+
+    font_index_init_done = TRUE;
+    if (!(font_index_path = get_unix_file_name( nameW ))) return;
+    if ((fd = open( font_index_path, O_RDONLY )) == -1) goto invalid;
+
+    if (!fstat( fd, &st ) && st.st_size >= sizeof(*header) && st.st_size <= 0x7fffffff)
+    {
+        header = mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+        if (header != MAP_FAILED)
+        {
+            if (header->magic == FONT_INDEX_MAGIC && header->version == FONT_INDEX_VERSION &&
+                header->lcid == system_lcid && header->size == st.st_size &&
+                header->count <= (header->size - sizeof(*header)) / sizeof(struct font_index_entry) &&
+                validate_font_index( header ))
+                font_index = header;
+            else munmap( (void *)header, st.st_size );
+        }
+    }
+    close( fd );
+    if (font_index)
+    {
+        TRACE( "using %u entries from %s\n", (int)font_index->count, debugstr_a(font_index_path) );
+        return;
+    }
+
+invalid:
+    TRACE( "no valid font index in %s\n", debugstr_a(font_index_path) );
+    font_index_dirty = TRUE;
+}
+
+static int font_index_compare( const char *file, DWORD flags, DWORD face_index,
+                               const char *file2, const struct font_index_entry *entry )
+{
+    DWORD flags2 = entry->flags & FONT_INDEX_ALLOW_BITMAP;
+    int ret;
+
+    if ((ret = strcmp( file, file2 ))) return ret;
+    flags &= FONT_INDEX_ALLOW_BITMAP;
+    if (flags != flags2) return flags < flags2 ? -1 : 1;
+    if (face_index != entry->face_index) return face_index < entry->face_index ? -1 : 1;
+    return 0;
+}
+
+static const struct font_index_entry *find_font_index_entry( const char *unix_name, const struct stat *st,
+                                                             DWORD face_index, DWORD flags )
+{
+    const struct font_index_entry *entries = (const struct font_index_entry *)(font_index + 1);
+    int min = 0, max = font_index->count - 1, pos, ret;
+    const char *file;
+
+    while (min <= max)
+    {
+        pos = (min + max) / 2;
+        if (!(file = get_font_index_string( entries[pos].file ))) return NULL;
+        if (!(ret = font_index_compare( unix_name, flags, face_index, file, &entries[pos] )))
+        {
+            if (entries[pos].mtime != st->st_mtime || entries[pos].file_size != st->st_size) return NULL;
+            return &entries[pos];
+        }
+        if (ret < 0) max = pos - 1;
+        else min = pos + 1;
+    }
+    return NULL;
+}
+
+static WCHAR *get_font_index_name( const struct font_index_entry *entry, int i )
+{
+    const WCHAR *name = (const WCHAR *)get_font_index_string( entry->names[i] );
+    return name ? wcsdup( name ) : NULL;
+}
+
+static void record_font_index_entry( const char *unix_name, const struct font_index_entry *entry,
+                                     WCHAR *names[4] )
+{
+    struct font_index_record *record;
+    int i;
+
+    if (font_index_record_count == font_index_record_size)
+    {
+        unsigned int new_size = max( 64, font_index_record_size * 2 );
+        if (!(record = realloc( font_index_records, new_size * sizeof(*record) )))
+        {
+            for (i = 0; i < 4; i++) free( names[i] );
+            return;
+        }
+        font_index_records = record;
+        font_index_record_size = new_size;
+    }
+    record = &font_index_records[font_index_record_count++];
+    record->file = strdup( unix_name );
+    record->entry = *entry;
+    for (i = 0; i < 4; i++) record->names[i] = names[i];
+}
+
+/* add a face using the properties stored in the index, returns -1 if it isn't indexed */
+static int add_indexed_face( const char *unix_name, const struct stat *st, const WCHAR *file,
+                             DWORD face_index, DWORD flags, DWORD *num_faces )
+{
+    const struct font_index_entry *entry;
+    WCHAR *names[4];
+    int i, ret = 0;
+
+    if (!font_index_init_done) open_font_index();
+    if (!font_index) return -1;
+    if (!(entry = find_font_index_entry( unix_name, st, face_index,
+                                         (flags & ADDFONT_ALLOW_BITMAP) ? FONT_INDEX_ALLOW_BITMAP : 0 )))
+        return -1;
+
+    if (num_faces) *num_faces = entry->num_faces;
+    for (i = 0; i < 4; i++) names[i] = get_font_index_name( entry, i );
+
+    if (entry->flags & FONT_INDEX_INVALID)
+        TRACE( "skipping invalid font %s\n", debugstr_a(unix_name) );
+    else if (names[0] && names[0][0] == '.') /* Ignore fonts with names beginning with a dot */
+        TRACE( "Ignoring %s since its family name begins with a dot\n", debugstr_a(unix_name) );
+    else
+    {
+        if (!HIWORD( flags )) flags |= ADDFONT_AA_FLAGS( default_aa_flags );
+        ret = add_gdi_face( names[0], names[1], names[2], names[3], file, NULL, 0, face_index,
+                            entry->fs, entry->ntm_flags, entry->font_version, flags,
+                            (entry->flags & FONT_INDEX_SCALABLE) ? NULL : &entry->size );
+    }
+
+    if (font_index_records) record_font_index_entry( unix_name, entry, names );
+    else for (i = 0; i < 4; i++) free( names[i] );
+    return ret;
+}
+
+/* store the properties of a parsed face, to be written to the index */
+static void add_font_index_entry( const char *unix_name, const struct stat *st, DWORD face_index,
+                                  DWORD flags, const struct unix_face *unix_face )
+{
+    struct font_index_entry entry;
+    WCHAR *names[4] = { NULL };
+
+    if (!font_index_records) return;
+
+    memset( &entry, 0, sizeof(entry) );
+    entry.mtime = st->st_mtime;
+    entry.file_size = st->st_size;
+    entry.face_index = face_index;
+    if (flags & ADDFONT_ALLOW_BITMAP) entry.flags |= FONT_INDEX_ALLOW_BITMAP;
+    if (unix_face)
+    {
+        if (unix_face->scalable) entry.flags |= FONT_INDEX_SCALABLE;
+        entry.num_faces = unix_face->num_faces;
+        entry.ntm_flags = unix_face->ntm_flags;
+        entry.font_version = unix_face->font_version;
+        entry.fs = unix_face->fs;
+        entry.size = unix_face->size;
+        if (unix_face->family_name) names[0] = wcsdup( unix_face->family_name );
+        if (unix_face->second_name) names[1] = wcsdup( unix_face->second_name );
+        if (unix_face->style_name) names[2] = wcsdup( unix_face->style_name );
+        if (unix_face->full_name) names[3] = wcsdup( unix_face->full_name );
+    }
+    else entry.flags |= FONT_INDEX_INVALID;
+
+    record_font_index_entry( unix_name, &entry, names );
+    font_index_dirty = TRUE;
+}
+
+static int font_index_record_compare( const void *p1, const void *p2 )
+{
+    const struct font_index_record *r1 = p1, *r2 = p2;
+    return font_index_compare( r1->file, r1->entry.flags, r1->entry.face_index, r2->file, &r2->entry );
+}
+
+static void write_font_index(void)
+{
+    struct font_index_header *header;
+    struct font_index_entry *entries;
+    struct font_index_record *record;
+    unsigned int i, j;
+    size_t size, len;
+    char *ptr, *tmp_path;
+    int fd;
+
+    size = sizeof(*header) + font_index_record_count * sizeof(*entries);
+    for (i = 0; i < font_index_record_count; i++)
+    {
+        record = &font_index_records[i];
+        size += (strlen( record->file ) + 2) & ~1;
+        for (j = 0; j < 4; j++)
+            if (record->names[j]) size += (lstrlenW( record->names[j] ) + 1) * sizeof(WCHAR);
+    }
+    if (size > 0x7fffffff || !(header = calloc( 1, size ))) return;
+
+    header->magic   = FONT_INDEX_MAGIC;
+    header->version = FONT_INDEX_VERSION;
+    header->lcid    = system_lcid;
+    header->count   = font_index_record_count;
+    header->size    = size;
+
+    entries = (struct font_index_entry *)(header + 1);
+    ptr = (char *)(entries + font_index_record_count);
+    for (i = 0; i < font_index_record_count; i++)
+    {
+        record = &font_index_records[i];
+        entries[i] = record->entry;
+        entries[i].file = ptr - (char *)header;
+        len = strlen( record->file ) + 1;
+        memcpy( ptr, record->file, len );
+        ptr += (len + 1) & ~1;
+        for (j = 0; j < 4; j++)
+        {
+            entries[i].names[j] = 0;
+            if (!record->names[j]) continue;
+            entries[i].names[j] = ptr - (char *)header;
+            len = (lstrlenW( record->names[j] ) + 1) * sizeof(WCHAR);
+            memcpy( ptr, record->names[j], len );
+            ptr += len;
+        }
+    }
+
+    /* write to a temporary file and atomically replace the old index */
+    if ((tmp_path = malloc( strlen( font_index_path ) + 16 )))
+    {
+        sprintf( tmp_path, "%s.%x", font_index_path, (int)getpid() );
+        if ((fd = open( tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644 )) != -1)
+        {
+            BOOL ok = write( fd, header, size ) == size;
+            close( fd );
+            if (!ok || rename( tmp_path, font_index_path ) == -1) unlink( tmp_path );
+            else TRACE( "wrote %u entries to %s\n", font_index_record_count, debugstr_a(font_index_path) );
+        }
+        free( tmp_path );
+    }
+    free( header );
+}
+
+static void free_font_index_record( struct font_index_record *record )
+{
+    int i;
+
+    free( record->file );
+    for (i = 0; i < 4; i++) free( record->names[i] );
+}
+
+/* start recording the faces found while loading the system fonts */
+static void begin_font_index_update(void)
+{
+    if (!font_index_init_done) open_font_index();
+    if (!font_index_path) return;
+    font_index_record_size = 256;
+    if (!(font_index_records = malloc( font_index_record_size * sizeof(*font_index_records) )))
+        font_index_record_size = 0;
+}
+
+/* rebuild the index if the set of system fonts changed */
+static void end_font_index_update(void)
+{
+    unsigned int i, count = 0;
+
+    if (!font_index_records) return;
+
+    /* the same file may be found in several directories */
+    qsort( font_index_records, font_index_record_count, sizeof(*font_index_records),
+           font_index_record_compare );
+    for (i = 0; i < font_index_record_count; i++)
+    {
+        struct font_index_record *record = &font_index_records[i];
+
+        if (!record->file || (count && !font_index_record_compare( record, &font_index_records[count - 1] )))
+            free_font_index_record( record );
+        else font_index_records[count++] = *record;
+    }
+    font_index_record_count = count;
+
+    if (font_index_dirty || !font_index || font_index->count != font_index_record_count)
+        write_font_index();
+
+    for (i = 0; i < font_index_record_count; i++) free_font_index_record( &font_index_records[i] );
+    free( font_index_records );
+    font_index_records = NULL;
+    font_index_record_count = font_index_record_size = 0;
+    font_index_dirty = FALSE;
+}
+
+static int add_unix_face( const char *unix_name, const WCHAR *file, void *data_ptr, SIZE_T data_size,
+                          DWORD face_index, DWORD flags, DWORD *num_faces )
+{
+    struct unix_face *unix_face;
+    struct stat st;
+    BOOL indexed = unix_name && !stat( unix_name, &st );
+    int ret;
+
+    if (num_faces) *num_faces = 0;
+
+    if (indexed && (ret = add_indexed_face( unix_name, &st, file, face_index, flags, num_faces )) >= 0)
+        return ret;
+
+    unix_face = unix_face_create( unix_name, data_ptr, data_size, face_index, flags );
+    if (indexed) add_font_index_entry( unix_name, &st, face_index, flags, unix_face );
+    if (!unix_face) return 0;
+
+    if (unix_face->family_name[0] == '.') /* Ignore fonts with names beginning with a dot */
+    {
+        TRACE("Ignoring %s since its family name begins with a dot\n", debugstr_a(unix_name));
+        unix_face_destroy( unix_face );
+        return 0;
+    }
+
+    if (!HIWORD( flags )) flags |= ADDFONT_AA_FLAGS( default_aa_flags );
+
+    ret = add_gdi_face( unix_face->family_name, unix_face->second_name, unix_face->style_name, unix_face->full_name,
+                        file, data_ptr, data_size, face_index, unix_face->fs, unix_face->ntm_flags,
+                        unix_face->font_version, flags, unix_face->scalable ? NULL : &unix_face->size );
+
+    TRACE("fsCsb = %08x %08x/%08x %08x %08x %08x\n",
+          (int)unix_face->fs.fsCsb[0], (int)unix_face->fs.fsCsb[1],
+          (int)unix_face->fs.fsUsb[0], (int)unix_face->fs.fsUsb[1],
+          (int)unix_face->fs.fsUsb[2], (int)unix_face->fs.fsUsb[3]);
+
+    if (num_faces) *num_faces = unix_face->num_faces;
+    unix_face_destroy( unix_face );
+    return ret;
+}
+
 static INT AddFontToList(const WCHAR *dos_name, const char *unix_name, void *font_data_ptr,
                          UINT font_data_size, UINT flags)
 {
@@ -1890,6 +2267,7 @@ static void freetype_load_fonts(void)
 #elif defined(__ANDROID__)
     ReadFontDir("/system/fonts", TRUE);
 #endif
+    end_font_index_update();
 }
 
 /* Some fonts have large usWinDescent values, as a result of storing signed short
@@ -4253,6 +4631,7 @@ const struct font_backend_funcs *init_freetype_lib(void)
     init_fontconfig();
 #endif
     NtQueryDefaultLocale( FALSE, &system_lcid );
+    begin_font_index_update();
     return &font_funcs;
 }
 
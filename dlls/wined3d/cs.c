@@ -20,6 +20,7 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
 WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
+WINE_DECLARE_DEBUG_CHANNEL(d3d_stats);
 WINE_DECLARE_DEBUG_CHANNEL(d3d_sync);
 WINE_DECLARE_DEBUG_CHANNEL(fps);
 
@@ -642,6 +643,130 @@ static struct wined3d_cs_packet *wined3d_next_cs_packet(const uint8_t *data, SIZ
     return packet;
 }
 
+/* Command stream statistics, only collected when the d3d_stats channel is
+ * enabled. Times are in performance counter ticks. Counters written by
+ * application threads are updated atomically; the CS thread reads them
+ * without locking, which is good enough for periodic dumps. */
+struct wined3d_cs_stats
+{
+    LONGLONG frequency;
+
+    /* Written by application threads. */
+    LONGLONG finish_time[WINED3D_CS_QUEUE_COUNT];
+    LONGLONG space_wait_time;
+    LONGLONG map_time;
+    LONGLONG present_wait_time;
+    LONG finish_count[WINED3D_CS_QUEUE_COUNT];
+    LONG space_wait_count;
+    LONG map_count;
+    LONG present_wait_count;
+    ULONG max_queue_depth;
+
+    /* Written by the thread executing commands. */
+    unsigned int op_count[WINED3D_CS_OP_STOP];
+    LONGLONG busy_time;
+
+    /* Values at the previous dump, only used by the dumping thread. */
+    struct
+    {
+        LONGLONG time;
+        LONGLONG finish_time[WINED3D_CS_QUEUE_COUNT];
+        LONGLONG space_wait_time;
+        LONGLONG map_time;
+        LONGLONG present_wait_time;
+        LONGLONG busy_time;
+        LONG finish_count[WINED3D_CS_QUEUE_COUNT];
+        LONG space_wait_count;
+        LONG map_count;
+        LONG present_wait_count;
+        unsigned int op_count[WINED3D_CS_OP_STOP];
+    } prev;
+};
+
+static inline LONGLONG wined3d_cs_stats_time(void)
+{
+    LARGE_INTEGER counter;
+
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+static inline void wined3d_cs_stats_add_time(LONGLONG *total, LONG *count, LONGLONG start)
+{
+    InterlockedExchangeAdd64(total, wined3d_cs_stats_time() - start);
+    InterlockedIncrement(count);
+}
+
+static double wined3d_cs_stats_ms(const struct wined3d_cs_stats *stats, LONGLONG ticks)
+{
+    return 1000.0 * ticks / stats->frequency;
+}
+
+static void wined3d_cs_dump_stats(struct wined3d_cs *cs)
+{
+    struct wined3d_cs_stats *stats = cs->stats;
+    LONGLONG time = wined3d_cs_stats_time(), interval;
+    unsigned int i, count;
+
+    interval = time - stats->prev.time;
+    if (interval < stats->frequency * 3 / 2)
+        return;
+
+    TRACE_(d3d_stats)("%p: %.2f ms interval, max queue depth %lu bytes.\n",
+            cs, wined3d_cs_stats_ms(stats, interval), stats->max_queue_depth);
+    stats->max_queue_depth = 0;
+
+    for (i = 0; i < WINED3D_CS_QUEUE_COUNT; ++i)
+    {
+        TRACE_(d3d_stats)("%p:   queue %u: %ld finishes, %.2f ms blocked.\n", cs, i,
+                stats->finish_count[i] - stats->prev.finish_count[i],
+                wined3d_cs_stats_ms(stats, stats->finish_time[i] - stats->prev.finish_time[i]));
+        stats->prev.finish_count[i] = stats->finish_count[i];
+        stats->prev.finish_time[i] = stats->finish_time[i];
+    }
+    TRACE_(d3d_stats)("%p:   %ld waits for queue space, %.2f ms blocked.\n", cs,
+            stats->space_wait_count - stats->prev.space_wait_count,
+            wined3d_cs_stats_ms(stats, stats->space_wait_time - stats->prev.space_wait_time));
+    TRACE_(d3d_stats)("%p:   %ld synchronous maps/unmaps, %.2f ms blocked.\n", cs,
+            stats->map_count - stats->prev.map_count,
+            wined3d_cs_stats_ms(stats, stats->map_time - stats->prev.map_time));
+    TRACE_(d3d_stats)("%p:   %ld waits for frame latency, %.2f ms blocked.\n", cs,
+            stats->present_wait_count - stats->prev.present_wait_count,
+            wined3d_cs_stats_ms(stats, stats->present_wait_time - stats->prev.present_wait_time));
+    TRACE_(d3d_stats)("%p:   %s thread busy %.2f ms, idle %.2f ms.\n", cs, cs->thread ? "CS" : "application",
+            wined3d_cs_stats_ms(stats, stats->busy_time - stats->prev.busy_time),
+            wined3d_cs_stats_ms(stats, interval - (stats->busy_time - stats->prev.busy_time)));
+    stats->prev.space_wait_count = stats->space_wait_count;
+    stats->prev.space_wait_time = stats->space_wait_time;
+    stats->prev.map_count = stats->map_count;
+    stats->prev.map_time = stats->map_time;
+    stats->prev.present_wait_count = stats->present_wait_count;
+    stats->prev.present_wait_time = stats->present_wait_time;
+    stats->prev.busy_time = stats->busy_time;
+
+    for (i = 0; i < WINED3D_CS_OP_STOP; ++i)
+    {
+        if (!(count = stats->op_count[i] - stats->prev.op_count[i]))
+            continue;
+        TRACE_(d3d_stats)("%p:   %s: %u.\n", cs, debug_cs_op(i), count);
+        stats->prev.op_count[i] = stats->op_count[i];
+    }
+
+    stats->prev.time = time;
+}
+
+static struct wined3d_cs_stats *wined3d_cs_create_stats(void)
+{
+    struct wined3d_cs_stats *stats;
+    LARGE_INTEGER frequency;
+
+    if (!QueryPerformanceFrequency(&frequency) || !(stats = heap_alloc_zero(sizeof(*stats))))
+        return NULL;
+    stats->frequency = frequency.QuadPart;
+    stats->prev.time = wined3d_cs_stats_time();
+    return stats;
+}
+
 static void wined3d_cs_exec_nop(struct wined3d_cs *cs, const void *data)
 {
 }
@@ -723,6 +848,9 @@ static void wined3d_cs_exec_present(struct wined3d_cs *cs, const void *data)
         }
     }
 
+    if (cs->stats)
+        wined3d_cs_dump_stats(cs);
+
     InterlockedDecrement(&cs->pending_presents);
     if (InterlockedCompareExchange(&cs->waiting_for_present, FALSE, TRUE))
         SetEvent(cs->present_event);
@@ -766,10 +894,14 @@ void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *sw
         pending = InterlockedCompareExchange(&cs->pending_presents, 0, 0);
         if (pending >= swapchain->max_frame_latency || !InterlockedCompareExchange(&cs->waiting_for_present, FALSE, TRUE))
         {
+            LONGLONG start = cs->stats ? wined3d_cs_stats_time() : 0;
+
             TRACE_(d3d_perf)("Reached latency limit (%u frames), blocking to wait.\n", swapchain->max_frame_latency);
             wined3d_mutex_unlock();
             WaitForSingleObject(cs->present_event, INFINITE);
             wined3d_mutex_lock();
+            if (cs->stats)
+                wined3d_cs_stats_add_time(&cs->stats->present_wait_time, &cs->stats->present_wait_count, start);
             TRACE_(d3d_perf)("Woken up from the wait.\n");
         }
     }
@@ -2435,11 +2567,20 @@ static void wined3d_cs_exec_map(struct wined3d_cs *cs, const void *data)
             op->sub_resource_idx, op->map_ptr, op->box, op->flags);
 }
 
+static struct wined3d_cs_stats *wined3d_device_context_get_stats(struct wined3d_device_context *context)
+{
+    struct wined3d_cs *cs = context->device->cs;
+
+    return context == &cs->c ? cs->stats : NULL;
+}
+
 HRESULT wined3d_device_context_emit_map(struct wined3d_device_context *context,
         struct wined3d_resource *resource, unsigned int sub_resource_idx,
         struct wined3d_map_desc *map_desc, const struct wined3d_box *box, unsigned int flags)
 {
+    struct wined3d_cs_stats *stats;
     struct wined3d_cs_map *op;
+    LONGLONG start = 0;
     HRESULT hr;
 
     /* Mapping resources from the worker thread isn't an issue by itself, but
@@ -2454,6 +2595,9 @@ HRESULT wined3d_device_context_emit_map(struct wined3d_device_context *context,
         return WINED3D_OK;
     }
 
+    if ((stats = wined3d_device_context_get_stats(context)))
+        start = wined3d_cs_stats_time();
+
     wined3d_resource_wait_idle(resource);
 
     /* We might end up invalidating the resource on the CS thread. */
@@ -2472,6 +2616,9 @@ HRESULT wined3d_device_context_emit_map(struct wined3d_device_context *context,
     wined3d_device_context_submit(context, WINED3D_CS_QUEUE_MAP);
     wined3d_device_context_finish(context, WINED3D_CS_QUEUE_MAP);
 
+    if (stats)
+        wined3d_cs_stats_add_time(&stats->map_time, &stats->map_count, start);
+
     if (SUCCEEDED(hr))
         wined3d_resource_get_sub_resource_map_pitch(resource, sub_resource_idx,
                 &map_desc->row_pitch, &map_desc->slice_pitch);
@@ -2489,9 +2636,11 @@ static void wined3d_cs_exec_unmap(struct wined3d_cs *cs, const void *data)
 HRESULT wined3d_device_context_emit_unmap(struct wined3d_device_context *context,
         struct wined3d_resource *resource, unsigned int sub_resource_idx)
 {
+    struct wined3d_cs_stats *stats;
     struct wined3d_cs_unmap *op;
     struct wined3d_box box;
     struct upload_bo bo;
+    LONGLONG start = 0;
     HRESULT hr;
 
     if (context->ops->unmap_upload_bo(context, resource, sub_resource_idx, &box, &bo))
@@ -2506,6 +2655,9 @@ HRESULT wined3d_device_context_emit_unmap(struct wined3d_device_context *context
 
     wined3d_not_from_cs(context->device->cs);
 
+    if ((stats = wined3d_device_context_get_stats(context)))
+        start = wined3d_cs_stats_time();
+
     if (!(op = wined3d_device_context_require_space(context, sizeof(*op), WINED3D_CS_QUEUE_MAP)))
         return E_OUTOFMEMORY;
     op->opcode = WINED3D_CS_OP_UNMAP;
@@ -2516,6 +2668,9 @@ HRESULT wined3d_device_context_emit_unmap(struct wined3d_device_context *context
     wined3d_device_context_submit(context, WINED3D_CS_QUEUE_MAP);
     wined3d_device_context_finish(context, WINED3D_CS_QUEUE_MAP);
 
+    if (stats)
+        wined3d_cs_stats_add_time(&stats->map_time, &stats->map_count, start);
+
     return hr;
 }
 
@@ -2985,6 +3140,15 @@ static void *wined3d_cs_st_require_space(struct wined3d_device_context *context,
     return (BYTE *)cs->data + cs->start;
 }
 
+static void wined3d_cs_execute_op_stats(struct wined3d_cs *cs, enum wined3d_cs_op opcode, const void *data)
+{
+    LONGLONG start = wined3d_cs_stats_time();
+
+    wined3d_cs_op_handlers[opcode](cs, data);
+    cs->stats->busy_time += wined3d_cs_stats_time() - start;
+    ++cs->stats->op_count[opcode];
+}
+
 static void wined3d_cs_st_submit(struct wined3d_device_context *context, enum wined3d_cs_queue_id queue_id)
 {
     struct wined3d_cs *cs = wined3d_cs_from_context(context);
@@ -2999,6 +3163,8 @@ static void wined3d_cs_st_submit(struct wined3d_device_context *context, enum wi
     opcode = *(const enum wined3d_cs_op *)&data[start];
     if (opcode >= WINED3D_CS_OP_STOP)
         ERR("Invalid opcode %#x.\n", opcode);
+    else if (cs->stats)
+        wined3d_cs_execute_op_stats(cs, opcode, &data[start]);
     else
         wined3d_cs_op_handlers[opcode](cs, &data[start]);
 
@@ -3188,6 +3354,15 @@ static void wined3d_cs_queue_submit(struct wined3d_cs_queue *queue, struct wined
     packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]);
     InterlockedExchange((LONG *)&queue->head, queue->head + packet_size);
 
+    if (cs->stats)
+    {
+        ULONG depth = (queue->head - *(volatile ULONG *)&queue->tail) & WINED3D_CS_QUEUE_MASK;
+
+        /* Racy, but only used for reporting. */
+        if (depth > cs->stats->max_queue_depth)
+            cs->stats->max_queue_depth = depth;
+    }
+
     if (InterlockedCompareExchange(&cs->waiting_for_event, FALSE, TRUE))
         SetEvent(cs->event);
 }
@@ -3208,6 +3383,8 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
     size_t header_size, packet_size, remaining;
     struct wined3d_cs_packet *packet;
     ULONG head = queue->head & WINED3D_CS_QUEUE_MASK;
+    LONGLONG start = 0;
+    bool waited;
 
     header_size = FIELD_OFFSET(struct wined3d_cs_packet, data[0]);
     packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[size]);
@@ -3236,7 +3413,7 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
         assert(!head);
     }
 
-    for (;;)
+    for (waited = false;; waited = true)
     {
         ULONG tail = (*(volatile ULONG *)&queue->tail) & WINED3D_CS_QUEUE_MASK;
         ULONG new_pos;
@@ -3256,8 +3433,13 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
 
         TRACE("Waiting for free space. Head %lu, tail %lu, packet size %Iu.\n",
                 head, tail, packet_size);
+        if (!waited && cs->stats)
+            start = wined3d_cs_stats_time();
     }
 
+    if (waited && cs->stats)
+        wined3d_cs_stats_add_time(&cs->stats->space_wait_time, &cs->stats->space_wait_count, start);
+
     packet = (struct wined3d_cs_packet *)&queue->data[head];
     packet->size = size;
     return packet->data;
@@ -3277,10 +3459,20 @@ static void *wined3d_cs_mt_require_space(struct wined3d_device_context *context,
 static void wined3d_cs_mt_finish(struct wined3d_device_context *context, enum wined3d_cs_queue_id queue_id)
 {
     struct wined3d_cs *cs = wined3d_cs_from_context(context);
+    LONGLONG start;
 
     if (cs->thread_id == GetCurrentThreadId())
         return wined3d_cs_st_finish(context, queue_id);
 
+    if (cs->stats)
+    {
+        start = wined3d_cs_stats_time();
+        while (cs->queue[queue_id].head != *(volatile ULONG *)&cs->queue[queue_id].tail)
+            YieldProcessor();
+        wined3d_cs_stats_add_time(&cs->stats->finish_time[queue_id], &cs->stats->finish_count[queue_id], start);
+        return;
+    }
+
     while (cs->queue[queue_id].head != *(volatile ULONG *)&cs->queue[queue_id].tail)
         YieldProcessor();
 }
@@ -3366,7 +3558,10 @@ static inline bool wined3d_cs_execute_next(struct wined3d_cs *cs, struct wined3d
         }
 
         wined3d_cs_command_lock(cs);
-        wined3d_cs_op_handlers[opcode](cs, packet->data);
+        if (cs->stats)
+            wined3d_cs_execute_op_stats(cs, opcode, packet->data);
+        else
+            wined3d_cs_op_handlers[opcode](cs, packet->data);
         wined3d_cs_command_unlock(cs);
         TRACE("%s at %p executed.\n", debug_cs_op(opcode), packet);
     }
@@ -3482,6 +3677,9 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device,
     if (cs->serialize_commands)
         ERR_(d3d_sync)("Forcing serialization of all command streams.\n");
 
+    if (TRACE_ON(d3d_stats))
+        cs->stats = wined3d_cs_create_stats();
+
     state_init(&cs->state, d3d_info, WINED3D_STATE_NO_REF | WINED3D_STATE_INIT_DEFAULT, cs->c.state->feature_level);
 
     cs->data_size = WINED3D_INITIAL_CS_SIZE;
@@ -3542,6 +3740,7 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device,
 fail:
     wined3d_state_destroy(cs->c.state);
     state_cleanup(&cs->state);
+    heap_free(cs->stats);
     heap_free(cs);
     return NULL;
 }
@@ -3560,6 +3759,7 @@ void wined3d_cs_destroy(struct wined3d_cs *cs)
 
     wined3d_state_destroy(cs->c.state);
     state_cleanup(&cs->state);
+    heap_free(cs->stats);
     heap_free(cs->data);
     heap_free(cs);
 }
@@ -4170,6 +4170,7 @@ struct wined3d_cs
     LONG waiting_for_event;
     LONG waiting_for_present;
     LONG pending_presents;
+    struct wined3d_cs_stats *stats;
 };
 
 static inline void wined3d_device_context_lock(struct wined3d_device_context *context)
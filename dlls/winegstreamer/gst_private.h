@@ -106,6 +106,8 @@ wg_transform_t wg_transform_create(const struct wg_format *input_format,
 void wg_transform_destroy(wg_transform_t transform);
 bool wg_transform_set_output_format(wg_transform_t transform, struct wg_format *format);
 bool wg_transform_get_status(wg_transform_t transform, bool *accepts_input);
+/* Returns the number of output bytes that couldn't be written in place and had to be copied. */
+bool wg_transform_get_stats(wg_transform_t transform, UINT64 *bytes_copied);
 HRESULT wg_transform_drain(wg_transform_t transform);
 HRESULT wg_transform_flush(wg_transform_t transform);
 
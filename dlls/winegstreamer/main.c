@@ -356,8 +356,13 @@ wg_transform_t wg_transform_create(const struct wg_format *input_format,
 
 void wg_transform_destroy(wg_transform_t transform)
 {
+    UINT64 bytes_copied;
+
     TRACE("transform %#I64x.\n", transform);
 
+    if (TRACE_ON(quartz) && wg_transform_get_stats(transform, &bytes_copied))
+        TRACE("transform %#I64x copied %I64u bytes.\n", transform, bytes_copied);
+
     WINE_UNIX_CALL(unix_wg_transform_destroy, &transform);
 }
 
@@ -413,6 +418,22 @@ bool wg_transform_get_status(wg_transform_t transform, bool *accepts_input)
     return true;
 }
 
+bool wg_transform_get_stats(wg_transform_t transform, UINT64 *bytes_copied)
+{
+    struct wg_transform_get_stats_params params =
+    {
+        .transform = transform,
+    };
+
+    TRACE("transform %#I64x, bytes_copied %p.\n", transform, bytes_copied);
+
+    if (WINE_UNIX_CALL(unix_wg_transform_get_stats, &params))
+        return false;
+
+    *bytes_copied = params.bytes_copied;
+    return true;
+}
+
 bool wg_transform_set_output_format(wg_transform_t transform, struct wg_format *format)
 {
     struct wg_transform_set_output_format_params params =
@@ -56,6 +56,7 @@ extern NTSTATUS wg_transform_read_data(void *args) DECLSPEC_HIDDEN;
 extern NTSTATUS wg_transform_get_status(void *args) DECLSPEC_HIDDEN;
 extern NTSTATUS wg_transform_drain(void *args) DECLSPEC_HIDDEN;
 extern NTSTATUS wg_transform_flush(void *args) DECLSPEC_HIDDEN;
+extern NTSTATUS wg_transform_get_stats(void *args) DECLSPEC_HIDDEN;
 
 /* wg_allocator.c */
 
@@ -71,5 +72,6 @@ extern void wg_allocator_destroy(GstAllocator *allocator) DECLSPEC_HIDDEN;
 extern void wg_allocator_provide_sample(GstAllocator *allocator, struct wg_sample *sample) DECLSPEC_HIDDEN;
 extern void wg_allocator_release_sample(GstAllocator *allocator, struct wg_sample *sample,
         bool discard_data) DECLSPEC_HIDDEN;
+extern UINT64 wg_allocator_get_bytes_copied(GstAllocator *allocator) DECLSPEC_HIDDEN;
 
 #endif /* __WINE_WINEGSTREAMER_UNIX_PRIVATE_H */
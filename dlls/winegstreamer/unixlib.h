@@ -363,6 +363,12 @@ struct wg_transform_get_status_params
     UINT32 accepts_input;
 };
 
+struct wg_transform_get_stats_params
+{
+    wg_transform_t transform;
+    UINT64 bytes_copied;
+};
+
 enum unix_funcs
 {
     unix_wg_init_gstreamer,
@@ -402,6 +408,7 @@ enum unix_funcs
     unix_wg_transform_get_status,
     unix_wg_transform_drain,
     unix_wg_transform_flush,
+    unix_wg_transform_get_stats,
 };
 
 #endif /* __WINE_WINEGSTREAMER_UNIXLIB_H */
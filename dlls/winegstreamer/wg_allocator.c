@@ -57,6 +57,7 @@ typedef struct
     struct list memory_list;
 
     struct wg_sample *next_sample;
+    UINT64 bytes_copied;
 } WgAllocator;
 
 typedef struct
@@ -97,6 +98,7 @@ static void release_memory_sample(WgAllocator *allocator, WgMemory *memory, bool
     {
         GST_WARNING("Copying %#zx bytes from sample %p, back to memory %p", memory->written, sample, memory);
         memcpy(get_unix_memory_data(memory), wg_sample_data(memory->sample), memory->written);
+        allocator->bytes_copied += memory->written;
     }
 
     memory->sample = NULL;
@@ -318,3 +320,15 @@ void wg_allocator_release_sample(GstAllocator *gst_allocator, struct wg_sample *
         GST_ERROR("Couldn't find memory for sample %p", sample);
     pthread_mutex_unlock(&allocator->mutex);
 }
+
+UINT64 wg_allocator_get_bytes_copied(GstAllocator *gst_allocator)
+{
+    WgAllocator *allocator = (WgAllocator *)gst_allocator;
+    UINT64 bytes_copied;
+
+    pthread_mutex_lock(&allocator->mutex);
+    bytes_copied = allocator->bytes_copied;
+    pthread_mutex_unlock(&allocator->mutex);
+
+    return bytes_copied;
+}
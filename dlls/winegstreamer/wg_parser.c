@@ -1945,6 +1945,7 @@ const unixlib_entry_t __wine_unix_call_funcs[] =
     X(wg_transform_get_status),
     X(wg_transform_drain),
     X(wg_transform_flush),
+    X(wg_transform_get_stats),
 };
 
 #ifdef _WIN64
@@ -2192,6 +2193,7 @@ const unixlib_entry_t __wine_unix_call_wow64_funcs[] =
     X(wg_transform_get_status),
     X(wg_transform_drain),
     X(wg_transform_flush),
+    X(wg_transform_get_stats),
 };
 
 #endif  /* _WIN64 */
@@ -61,6 +61,8 @@ struct wg_transform
     GstSample *output_sample;
     bool output_caps_changed;
     GstCaps *output_caps;
+
+    UINT64 bytes_copied;
 };
 
 static struct wg_transform *get_transform(wg_transform_t trans)
@@ -144,7 +146,15 @@ static gboolean transform_sink_query_cb(GstPad *pad, GstObject *parent, GstQuery
             GstCaps *caps;
 
             gst_query_parse_allocation(query, &caps, &needs_pool);
-            if (stream_type_from_caps(caps) != GST_STREAM_TYPE_VIDEO || !needs_pool)
+            if (stream_type_from_caps(caps) != GST_STREAM_TYPE_VIDEO)
+            {
+                /* No alignment constraints, let the element allocate from the
+                 * output sample directly so that we don't need to copy. */
+                gst_query_add_allocation_param(query, transform->allocator, NULL);
+                GST_INFO("Proposing allocator %p for query %p.", transform->allocator, query);
+                return true;
+            }
+            if (!needs_pool)
                 break;
 
             if (!gst_video_info_from_caps(&info, caps)
@@ -683,8 +693,8 @@ static NTSTATUS copy_buffer(GstBuffer *buffer, GstCaps *caps, struct wg_sample *
     return STATUS_SUCCESS;
 }
 
-static NTSTATUS read_transform_output_data(GstBuffer *buffer, GstCaps *caps, gsize plane_align,
-        struct wg_sample *sample)
+static NTSTATUS read_transform_output_data(struct wg_transform *transform, GstBuffer *buffer,
+        GstCaps *caps, gsize plane_align, struct wg_sample *sample)
 {
     gsize total_size;
     bool needs_copy;
@@ -739,6 +749,7 @@ static NTSTATUS read_transform_output_data(GstBuffer *buffer, GstCaps *caps, gsi
 
     if (needs_copy)
     {
+        transform->bytes_copied += sample->size;
         if (stream_type_from_caps(caps) == GST_STREAM_TYPE_VIDEO)
             GST_WARNING("Copied %u bytes, sample %p, flags %#x", sample->size, sample, sample->flags);
         else
@@ -832,7 +843,7 @@ NTSTATUS wg_transform_read_data(void *args)
         return STATUS_SUCCESS;
     }
 
-    if ((status = read_transform_output_data(output_buffer, output_caps,
+    if ((status = read_transform_output_data(transform, output_buffer, output_caps,
                 transform->attrs.output_plane_align, sample)))
     {
         wg_allocator_release_sample(transform->allocator, sample, false);
@@ -876,6 +887,15 @@ NTSTATUS wg_transform_get_status(void *args)
     return STATUS_SUCCESS;
 }
 
+NTSTATUS wg_transform_get_stats(void *args)
+{
+    struct wg_transform_get_stats_params *params = args;
+    struct wg_transform *transform = get_transform(params->transform);
+
+    params->bytes_copied = transform->bytes_copied + wg_allocator_get_bytes_copied(transform->allocator);
+    return STATUS_SUCCESS;
+}
+
 NTSTATUS wg_transform_drain(void *args)
 {
     struct wg_transform *transform = get_transform(*(wg_transform_t *)args);
@@ -51,6 +51,7 @@
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(bitblt);
+WINE_DECLARE_DEBUG_CHANNEL(surface_upload);
 
 
 #define DST 0   /* Destination drawable */
@@ -1571,6 +1572,8 @@ DWORD get_pixmap_image( Pixmap pixmap, int width, int height, const XVisualInfo
 }
 
 
+#define MAX_DAMAGE_RECTS 8
+
 struct x11drv_window_surface
 {
     struct window_surface header;
@@ -1578,6 +1581,8 @@ struct x11drv_window_surface
     GC                    gc;
     XImage               *image;
     RECT                  bounds;
+    RECT                  damage[MAX_DAMAGE_RECTS];  /* damaged rects, their union is bounds */
+    UINT                  damage_count;
     BOOL                  byteswap;
     BOOL                  is_argb;
     DWORD                 alpha_bits;
@@ -1869,6 +1874,65 @@ static RECT *x11drv_surface_get_bounds( struct window_surface *window_surface )
     return &surface->bounds;
 }
 
+static inline LONGLONG get_rect_area( const RECT *rect )
+{
+    return (LONGLONG)(rect->right - rect->left) * (rect->bottom - rect->top);
+}
+
+/***********************************************************************
+ *           add_surface_damage
+ *
+ * Add a rectangle to the damage list, merging it with the existing ones
+ * when that doesn't waste too many pixels. Surface must be locked.
+ */
+static void add_surface_damage( struct x11drv_window_surface *surface, const RECT *rect )
+{
+    RECT merged, new_rect = *rect;
+    LONGLONG waste;
+    UINT i = 0;
+
+    if (rect->left >= rect->right || rect->top >= rect->bottom) return;
+    add_bounds_rect( &surface->bounds, rect );
+
+    while (i < surface->damage_count)
+    {
+        RECT *damage = &surface->damage[i];
+
+        merged.left   = min( damage->left, new_rect.left );
+        merged.top    = min( damage->top, new_rect.top );
+        merged.right  = max( damage->right, new_rect.right );
+        merged.bottom = max( damage->bottom, new_rect.bottom );
+        waste = get_rect_area( &merged ) - get_rect_area( damage ) - get_rect_area( &new_rect );
+        if (waste > 64 * 64 && waste > get_rect_area( &merged ) / 4)
+        {
+            i++;
+            continue;
+        }
+        /* the merged rect may now touch rects we already skipped, so start over */
+        new_rect = merged;
+        *damage = surface->damage[--surface->damage_count];
+        i = 0;
+    }
+
+    if (surface->damage_count == MAX_DAMAGE_RECTS)
+    {
+        /* too fragmented, fall back to the bounding box */
+        surface->damage[0] = surface->bounds;
+        surface->damage_count = 1;
+    }
+    else surface->damage[surface->damage_count++] = new_rect;
+}
+
+/***********************************************************************
+ *           x11drv_surface_add_bounds
+ */
+static void x11drv_surface_add_bounds( struct window_surface *window_surface, const RECT *rect )
+{
+    struct x11drv_window_surface *surface = get_x11_surface( window_surface );
+
+    add_surface_damage( surface, rect );
+}
+
 /***********************************************************************
  *           x11drv_surface_set_region
  */
@@ -1900,70 +1964,124 @@ static void x11drv_surface_set_region( struct window_surface *window_surface, HR
     window_surface->funcs->unlock( window_surface );
 }
 
+/***********************************************************************
+ *           trace_upload_stats
+ */
+static void trace_upload_stats( UINT rects, ULONGLONG bytes )
+{
+    static ULONGLONG total_bytes, interval_bytes;
+    static UINT interval_rects, interval_flushes;
+    static DWORD prev_time, start_time;
+    DWORD time = NtGetTickCount();
+
+    interval_bytes += bytes;
+    total_bytes += bytes;
+    interval_rects += rects;
+    interval_flushes++;
+    if (!start_time) start_time = prev_time = time;
+    if (time - prev_time > 1500)
+    {
+        TRACE_(surface_upload)( "%u flushes, %u rects, approx %.2f KiB/s, total %.2f KiB/s\n",
+                                interval_flushes, interval_rects,
+                                1000.0 * interval_bytes / 1024 / (time - prev_time),
+                                1000.0 * total_bytes / 1024 / (time - start_time) );
+        prev_time = time;
+        interval_bytes = 0;
+        interval_rects = interval_flushes = 0;
+    }
+}
+
+/***********************************************************************
+ *           flush_surface_rect
+ */
+static ULONGLONG flush_surface_rect( struct x11drv_window_surface *surface, const RECT *rect )
+{
+    unsigned char *src = surface->bits;
+    unsigned char *dst = (unsigned char *)surface->image->data;
+    int width_bytes = surface->image->bytes_per_line;
+
+    if (src != dst)
+    {
+        int map[256], *mapping = get_window_surface_mapping( surface->image->bits_per_pixel, map );
+
+        src += rect->top * width_bytes;
+        dst += rect->top * width_bytes;
+        copy_image_byteswap( &surface->info, src, dst, width_bytes, width_bytes,
+                             rect->bottom - rect->top,
+                             surface->byteswap, mapping, ~0u, surface->alpha_bits );
+    }
+    else if (surface->alpha_bits)
+    {
+        int x, y, stride = width_bytes / sizeof(ULONG);
+        ULONG *ptr = (ULONG *)dst + rect->top * stride;
+
+        for (y = rect->top; y < rect->bottom; y++, ptr += stride)
+            for (x = rect->left; x < rect->right; x++)
+                ptr[x] |= surface->alpha_bits;
+    }
+
+#ifdef HAVE_LIBXXSHM
+    if (surface->shminfo.shmid != -1)
+        XShmPutImage( gdi_display, surface->window, surface->gc, surface->image,
+                      rect->left, rect->top,
+                      surface->header.rect.left + rect->left,
+                      surface->header.rect.top + rect->top,
+                      rect->right - rect->left, rect->bottom - rect->top, False );
+    else
+#endif
+    XPutImage( gdi_display, surface->window, surface->gc, surface->image,
+               rect->left, rect->top,
+               surface->header.rect.left + rect->left,
+               surface->header.rect.top + rect->top,
+               rect->right - rect->left, rect->bottom - rect->top );
+
+    return (ULONGLONG)(rect->bottom - rect->top) *
+           (((rect->right - rect->left) * surface->image->bits_per_pixel + 7) / 8);
+}
+
 /***********************************************************************
  *           x11drv_surface_flush
  */
 static void x11drv_surface_flush( struct window_surface *window_surface )
 {
     struct x11drv_window_surface *surface = get_x11_surface( window_surface );
-    unsigned char *src = surface->bits;
-    unsigned char *dst = (unsigned char *)surface->image->data;
-    struct bitblt_coords coords;
+    RECT surface_rect, damage_bounds, rect;
+    ULONGLONG bytes = 0;
+    UINT i, count = 0;
 
     window_surface->funcs->lock( window_surface );
-    coords.x = 0;
-    coords.y = 0;
-    coords.width  = surface->header.rect.right - surface->header.rect.left;
-    coords.height = surface->header.rect.bottom - surface->header.rect.top;
-    SetRect( &coords.visrect, 0, 0, coords.width, coords.height );
-    if (intersect_rect( &coords.visrect, &coords.visrect, &surface->bounds ))
+    SetRect( &surface_rect, 0, 0, surface->header.rect.right - surface->header.rect.left,
+             surface->header.rect.bottom - surface->header.rect.top );
+
+    /* bounds can also be updated directly through get_bounds, in which case
+     * the damage list no longer covers them and we flush the bounding box */
+    reset_bounds( &damage_bounds );
+    for (i = 0; i < surface->damage_count; i++) add_bounds_rect( &damage_bounds, &surface->damage[i] );
+    if (!EqualRect( &damage_bounds, &surface->bounds ))
     {
-        TRACE( "flushing %p %dx%d bounds %s bits %p\n",
-               surface, coords.width, coords.height,
-               wine_dbgstr_rect( &surface->bounds ), surface->bits );
+        surface->damage[0] = surface->bounds;
+        surface->damage_count = 1;
+    }
+
+    if (intersect_rect( &rect, &surface_rect, &surface->bounds ))
+    {
+        TRACE( "flushing %p %dx%d bounds %s in %u rects bits %p\n",
+               surface, surface_rect.right, surface_rect.bottom,
+               wine_dbgstr_rect( &surface->bounds ), surface->damage_count, surface->bits );
 
         if (surface->is_argb || surface->color_key != CLR_INVALID) update_surface_region( surface );
 
-        if (src != dst)
+        for (i = 0; i < surface->damage_count; i++)
         {
-            int map[256], *mapping = get_window_surface_mapping( surface->image->bits_per_pixel, map );
-            int width_bytes = surface->image->bytes_per_line;
-
-            src += coords.visrect.top * width_bytes;
-            dst += coords.visrect.top * width_bytes;
-            copy_image_byteswap( &surface->info, src, dst, width_bytes, width_bytes,
-                                 coords.visrect.bottom - coords.visrect.top,
-                                 surface->byteswap, mapping, ~0u, surface->alpha_bits );
+            if (!intersect_rect( &rect, &surface_rect, &surface->damage[i] )) continue;
+            bytes += flush_surface_rect( surface, &rect );
+            count++;
         }
-        else if (surface->alpha_bits)
-        {
-            int x, y, stride = surface->image->bytes_per_line / sizeof(ULONG);
-            ULONG *ptr = (ULONG *)dst + coords.visrect.top * stride;
-
-            for (y = coords.visrect.top; y < coords.visrect.bottom; y++, ptr += stride)
-                for (x = coords.visrect.left; x < coords.visrect.right; x++)
-                    ptr[x] |= surface->alpha_bits;
-        }
-
-#ifdef HAVE_LIBXXSHM
-        if (surface->shminfo.shmid != -1)
-            XShmPutImage( gdi_display, surface->window, surface->gc, surface->image,
-                          coords.visrect.left, coords.visrect.top,
-                          surface->header.rect.left + coords.visrect.left,
-                          surface->header.rect.top + coords.visrect.top,
-                          coords.visrect.right - coords.visrect.left,
-                          coords.visrect.bottom - coords.visrect.top, False );
-        else
-#endif
-        XPutImage( gdi_display, surface->window, surface->gc, surface->image,
-                   coords.visrect.left, coords.visrect.top,
-                   surface->header.rect.left + coords.visrect.left,
-                   surface->header.rect.top + coords.visrect.top,
-                   coords.visrect.right - coords.visrect.left,
-                   coords.visrect.bottom - coords.visrect.top );
         XFlush( gdi_display );
+        if (TRACE_ON(surface_upload)) trace_upload_stats( count, bytes );
     }
     reset_bounds( &surface->bounds );
+    surface->damage_count = 0;
     window_surface->funcs->unlock( window_surface );
 }
 
@@ -2003,7 +2121,8 @@ static const struct window_surface_funcs x11drv_surface_funcs =
     x11drv_surface_get_bounds,
     x11drv_surface_set_region,
     x11drv_surface_flush,
-    x11drv_surface_destroy
+    x11drv_surface_destroy,
+    x11drv_surface_add_bounds
 };
 
 /***********************************************************************
@@ -2105,7 +2224,7 @@ HRGN expose_surface( struct window_surface *window_surface, const RECT *rect )
 
     window_surface->funcs->lock( window_surface );
     OffsetRect( &rc, -window_surface->rect.left, -window_surface->rect.top );
-    add_bounds_rect( &surface->bounds, &rc );
+    add_surface_damage( surface, &rc );
     if (surface->region)
     {
         region = NtGdiCreateRectRgn( rect->left, rect->top, rect->right, rect->bottom );
@@ -23,6 +23,7 @@
  */
 
 #include "ws2_32_private.h"
+#include "wine/list.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(winsock);
 WINE_DECLARE_DEBUG_CHANNEL(winediag);
@@ -46,8 +47,8 @@ static char *get_fqdn(void)
 }
 
 /* call Unix getaddrinfo, allocating a large enough buffer */
-static int do_getaddrinfo( const char *node, const char *service,
-                           const struct addrinfo *hints, struct addrinfo **info )
+static int call_getaddrinfo( const char *node, const char *service, const struct addrinfo *hints,
+                             struct addrinfo **info, unsigned int *ret_size )
 {
     unsigned int size = 1024;
     struct getaddrinfo_params params = { node, service, hints, NULL, &size };
@@ -60,6 +61,7 @@ static int do_getaddrinfo( const char *node, const char *service,
         if (!(ret = WS_CALL( getaddrinfo, &params )))
         {
             *info = params.info;
+            *ret_size = size;
             return ret;
         }
         free( params.info );
@@ -67,6 +69,264 @@ static int do_getaddrinfo( const char *node, const char *service,
     }
 }
 
+/* Optional cache of name lookups, enabled by setting MaxCacheTtl (and MaxNegativeCacheTtl for
+ * failed lookups) in seconds under the Dnscache service parameters. As on Windows, these bound
+ * the TTL of the address records. Results are kept in the packed form returned by the Unix side,
+ * and relocated when copied out. */
+
+#define ADDRINFO_CACHE_MAX_ENTRIES 128
+
+struct addrinfo_cache_entry
+{
+    struct list entry;
+    char *node;
+    char *service;
+    int flags;
+    int family;
+    int socktype;
+    int protocol;
+    int ret;
+    struct addrinfo *info;
+    unsigned int size;
+    ULONGLONG expire;
+};
+
+static struct list addrinfo_cache = LIST_INIT( addrinfo_cache );
+static unsigned int addrinfo_cache_count;
+static unsigned int addrinfo_cache_hits, addrinfo_cache_misses;
+static DWORD addrinfo_cache_max_ttl, addrinfo_cache_max_negative_ttl;
+
+DECLARE_CRITICAL_SECTION(addrinfo_cache_cs);
+
+static BOOL WINAPI init_addrinfo_cache( INIT_ONCE *once, void *param, void **context )
+{
+    static const WCHAR key[] = L"System\\CurrentControlSet\\Services\\Dnscache\\Parameters";
+    DWORD size = sizeof(DWORD);
+
+    if (RegGetValueW( HKEY_LOCAL_MACHINE, key, L"MaxCacheTtl", RRF_RT_REG_DWORD, NULL,
+                      &addrinfo_cache_max_ttl, &size )) addrinfo_cache_max_ttl = 0;
+    size = sizeof(DWORD);
+    if (!addrinfo_cache_max_ttl || RegGetValueW( HKEY_LOCAL_MACHINE, key, L"MaxNegativeCacheTtl", RRF_RT_REG_DWORD,
+                                                 NULL, &addrinfo_cache_max_negative_ttl, &size ))
+        addrinfo_cache_max_negative_ttl = 0;
+
+    TRACE( "max ttl %lu, max negative ttl %lu\n", addrinfo_cache_max_ttl, addrinfo_cache_max_negative_ttl );
+    return TRUE;
+}
+
+static BOOL addrinfo_cache_enabled(void)
+{
+    static INIT_ONCE init_once = INIT_ONCE_STATIC_INIT;
+
+    InitOnceExecuteOnce( &init_once, init_addrinfo_cache, NULL, NULL );
+    return addrinfo_cache_max_ttl != 0;
+}
+
+static BOOL strings_equal( const char *str1, const char *str2 )
+{
+    if (!str1 || !str2) return str1 == str2;
+    return !strcmp( str1, str2 );
+}
+
+static void free_addrinfo_cache_entry( struct addrinfo_cache_entry *entry )
+{
+    list_remove( &entry->entry );
+    addrinfo_cache_count--;
+    free( entry->node );
+    free( entry->service );
+    free( entry->info );
+    free( entry );
+}
+
+static struct addrinfo *copy_addrinfo( const struct addrinfo *src, unsigned int size )
+{
+    struct addrinfo *ret, *ai;
+    INT_PTR delta;
+
+    if (!(ret = malloc( size ))) return NULL;
+    memcpy( ret, src, size );
+    delta = (char *)ret - (const char *)src;
+
+    for (ai = ret; ai; ai = ai->ai_next)
+    {
+        if (ai->ai_canonname) ai->ai_canonname += delta;
+        if (ai->ai_addr) ai->ai_addr = (struct sockaddr *)((char *)ai->ai_addr + delta);
+        if (ai->ai_next) ai->ai_next = (struct addrinfo *)((char *)ai->ai_next + delta);
+    }
+    return ret;
+}
+
+static BOOL lookup_addrinfo_cache( const char *node, const char *service, const struct addrinfo *hints,
+                                   struct addrinfo **info, int *ret )
+{
+    struct addrinfo_cache_entry *entry, *next;
+    ULONGLONG now = GetTickCount64();
+    BOOL found = FALSE;
+
+    EnterCriticalSection( &addrinfo_cache_cs );
+    LIST_FOR_EACH_ENTRY_SAFE( entry, next, &addrinfo_cache, struct addrinfo_cache_entry, entry )
+    {
+        if (entry->expire <= now)
+        {
+            free_addrinfo_cache_entry( entry );
+            continue;
+        }
+        if (!_stricmp( entry->node, node ) && strings_equal( entry->service, service )
+            && entry->flags == (hints ? hints->ai_flags : 0)
+            && entry->family == (hints ? hints->ai_family : AF_UNSPEC)
+            && entry->socktype == (hints ? hints->ai_socktype : 0)
+            && entry->protocol == (hints ? hints->ai_protocol : 0))
+        {
+            if (!(*ret = entry->ret) && !(*info = copy_addrinfo( entry->info, entry->size ))) break;
+            list_remove( &entry->entry );
+            list_add_head( &addrinfo_cache, &entry->entry );
+            found = TRUE;
+            break;
+        }
+    }
+    if (found) addrinfo_cache_hits++;
+    else addrinfo_cache_misses++;
+    TRACE( "%s %s, %u hits, %u misses\n", debugstr_a(node), found ? "found" : "not found",
+           addrinfo_cache_hits, addrinfo_cache_misses );
+    LeaveCriticalSection( &addrinfo_cache_cs );
+    return found;
+}
+
+/* the Unix getaddrinfo doesn't return the record TTLs, so query them separately */
+static DWORD get_record_ttl( const char *node, WORD type )
+{
+    DNS_RECORDA *rec, *ptr;
+    DWORD ttl = ~0u;
+
+    if (DnsQuery_A( node, type, DNS_QUERY_NO_NETBT | DNS_QUERY_NO_MULTICAST, NULL, &rec, NULL )) return 0;
+    for (ptr = rec; ptr; ptr = ptr->pNext)
+        if (ptr->Flags.S.Section == DnsSectionAnswer) ttl = min( ttl, ptr->dwTtl );
+    DnsRecordListFree( (DNS_RECORD *)rec, DnsFreeRecordList );
+    return ttl == ~0u ? 0 : ttl;
+}
+
+/* Names that don't come from DNS, such as numeric addresses or hosts file entries, have no TTL
+ * and are not cached. The negative TTL of failed lookups is not available either, so they are
+ * kept for MaxNegativeCacheTtl. */
+static DWORD get_addrinfo_ttl( const char *node, const struct addrinfo *info, int ret )
+{
+    BOOL inet = FALSE, inet6 = FALSE;
+    DWORD ttl = addrinfo_cache_max_ttl;
+
+    if (ret) return addrinfo_cache_max_negative_ttl;
+
+    for (; info; info = info->ai_next)
+    {
+        if (info->ai_family == AF_INET) inet = TRUE;
+        else if (info->ai_family == AF_INET6) inet6 = TRUE;
+    }
+    if (!inet && !inet6) return 0;
+    if (inet) ttl = min( ttl, get_record_ttl( node, DNS_TYPE_A ) );
+    if (inet6) ttl = min( ttl, get_record_ttl( node, DNS_TYPE_AAAA ) );
+    return ttl;
+}
+
+static void add_addrinfo_cache( const char *node, const char *service, const struct addrinfo *hints,
+                                const struct addrinfo *info, unsigned int size, int ret )
+{
+    struct addrinfo_cache_entry *entry;
+    DWORD ttl = get_addrinfo_ttl( node, info, ret );
+
+    TRACE( "%s ttl %lu\n", debugstr_a(node), ttl );
+    if (!ttl) return;
+    if (!(entry = calloc( 1, sizeof(*entry) ))) return;
+    entry->node = strdup( node );
+    if (service) entry->service = strdup( service );
+    if (!ret) entry->info = copy_addrinfo( info, size );
+    if (!entry->node || (service && !entry->service) || (!ret && !entry->info))
+    {
+        free( entry->node );
+        free( entry->service );
+        free( entry->info );
+        free( entry );
+        return;
+    }
+    entry->flags    = hints ? hints->ai_flags : 0;
+    entry->family   = hints ? hints->ai_family : AF_UNSPEC;
+    entry->socktype = hints ? hints->ai_socktype : 0;
+    entry->protocol = hints ? hints->ai_protocol : 0;
+    entry->ret      = ret;
+    entry->size     = size;
+    entry->expire   = GetTickCount64() + (ULONGLONG)ttl * 1000;
+
+    EnterCriticalSection( &addrinfo_cache_cs );
+    if (addrinfo_cache_count == ADDRINFO_CACHE_MAX_ENTRIES)
+        free_addrinfo_cache_entry( LIST_ENTRY( list_tail( &addrinfo_cache ), struct addrinfo_cache_entry, entry ) );
+    list_add_head( &addrinfo_cache, &entry->entry );
+    addrinfo_cache_count++;
+    LeaveCriticalSection( &addrinfo_cache_cs );
+}
+
+/***********************************************************************
+ *      __wine_flush_addrinfo_cache   (ws2_32.@)
+ *
+ * Called by dnsapi to flush the whole cache, or the entries for a single name.
+ */
+void WINAPI __wine_flush_addrinfo_cache( const char *node )
+{
+    struct addrinfo_cache_entry *entry, *next;
+
+    TRACE( "%s\n", debugstr_a(node) );
+
+    EnterCriticalSection( &addrinfo_cache_cs );
+    LIST_FOR_EACH_ENTRY_SAFE( entry, next, &addrinfo_cache, struct addrinfo_cache_entry, entry )
+    {
+        if (!node || !_stricmp( entry->node, node )) free_addrinfo_cache_entry( entry );
+    }
+    LeaveCriticalSection( &addrinfo_cache_cs );
+}
+
+/***********************************************************************
+ *      __wine_enum_addrinfo_cache   (ws2_32.@)
+ *
+ * Called by dnsapi to list the names and record types of the unexpired entries.
+ */
+void WINAPI __wine_enum_addrinfo_cache( void (CALLBACK *callback)( const char *node, WORD type, void *context ),
+                                        void *context )
+{
+    struct addrinfo_cache_entry *entry;
+    ULONGLONG now = GetTickCount64();
+    const struct addrinfo *ai;
+    BOOL inet, inet6;
+
+    EnterCriticalSection( &addrinfo_cache_cs );
+    LIST_FOR_EACH_ENTRY( entry, &addrinfo_cache, struct addrinfo_cache_entry, entry )
+    {
+        if (entry->expire <= now) continue;
+        inet = entry->ret && entry->family != AF_INET6;
+        inet6 = entry->ret && entry->family == AF_INET6;
+        for (ai = entry->info; ai; ai = ai->ai_next)
+        {
+            if (ai->ai_family == AF_INET) inet = TRUE;
+            else if (ai->ai_family == AF_INET6) inet6 = TRUE;
+        }
+        if (inet) callback( entry->node, DNS_TYPE_A, context );
+        if (inet6) callback( entry->node, DNS_TYPE_AAAA, context );
+    }
+    LeaveCriticalSection( &addrinfo_cache_cs );
+}
+
+static int do_getaddrinfo( const char *node, const char *service,
+                           const struct addrinfo *hints, struct addrinfo **info )
+{
+    unsigned int size = 0;
+    int ret;
+
+    if (!node || !addrinfo_cache_enabled()) return call_getaddrinfo( node, service, hints, info, &size );
+
+    if (lookup_addrinfo_cache( node, service, hints, info, &ret )) return ret;
+
+    ret = call_getaddrinfo( node, service, hints, info, &size );
+    if (!ret || ret == WSAHOST_NOT_FOUND || ret == WSANO_DATA)
+        add_addrinfo_cache( node, service, hints, ret ? NULL : *info, size, ret );
+    return ret;
+}
+
 static int dns_only_query( const char *node, const struct addrinfo *hints, struct addrinfo **result )
 {
     DNS_STATUS status;
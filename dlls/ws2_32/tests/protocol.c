@@ -29,6 +29,7 @@
 #include <ws2spi.h>
 #include <mswsock.h>
 #include <iphlpapi.h>
+#include <windns.h>
 
 #include "wine/test.h"
 
@@ -2505,6 +2506,170 @@ static void test_getaddrinfo(void)
     }
 }
 
+static void (WINAPI *pDnsFlushResolverCache)(void);
+static BOOL (WINAPI *pDnsFlushResolverCacheEntry_A)(const char *);
+static BOOL (WINAPI *pDnsFlushResolverCacheEntry_W)(const WCHAR *);
+
+static BOOL is_name_cached(const WCHAR *name, WORD type)
+{
+    DNS_CACHE_ENTRY *entry, *next;
+    BOOL found = FALSE;
+
+    if (!DnsGetCacheDataTable(&entry)) return FALSE;
+    for (; entry; entry = next)
+    {
+        if (!lstrcmpiW(entry->Name, name) && entry->Type == type) found = TRUE;
+        next = entry->Next;
+        DnsFree(entry, DnsFreeFlat);
+    }
+    return found;
+}
+
+static void test_addrinfo_cache_child(void)
+{
+    /* te su to.winehq.org written in katakana */
+    static const WCHAR idn_domain[] =
+        {0x30C6,0x30B9,0x30C8,'.','w','i','n','e','h','q','.','o','r','g',0};
+    static const WCHAR idn_punycode[] =
+        {'x','n','-','-','z','c','k','z','a','h','.','w','i','n','e','h','q','.','o','r','g',0};
+    struct addrinfo hint, *result, *result2;
+    ADDRINFOW hintW, *resultW;
+    HMODULE dnsapi = GetModuleHandleA("dnsapi");
+    int ret;
+
+    pDnsFlushResolverCache = (void *)GetProcAddress(dnsapi, "DnsFlushResolverCache");
+    pDnsFlushResolverCacheEntry_A = (void *)GetProcAddress(dnsapi, "DnsFlushResolverCacheEntry_A");
+    pDnsFlushResolverCacheEntry_W = (void *)GetProcAddress(dnsapi, "DnsFlushResolverCacheEntry_W");
+
+    memset(&hint, 0, sizeof(hint));
+    hint.ai_family = AF_INET;
+    ret = getaddrinfo("test.winehq.org", NULL, &hint, &result);
+    if (ret)
+    {
+        skip("test.winehq.org can't be resolved, error %d\n", ret);
+        return;
+    }
+    ok(is_name_cached(L"test.winehq.org", DNS_TYPE_A), "name not cached\n");
+    ok(!is_name_cached(L"test.winehq.org", DNS_TYPE_AAAA), "AAAA record cached\n");
+
+    ret = getaddrinfo("TEST.winehq.org", NULL, &hint, &result2);
+    ok(!ret, "getaddrinfo failed with %d\n", ret);
+    ok(result2->ai_family == AF_INET, "got family %d\n", result2->ai_family);
+    ok(((SOCKADDR_IN *)result2->ai_addr)->sin_addr.s_addr == ((SOCKADDR_IN *)result->ai_addr)->sin_addr.s_addr,
+       "got a different address\n");
+    freeaddrinfo(result2);
+    freeaddrinfo(result);
+
+    ok(pDnsFlushResolverCacheEntry_A("test.winehq.org"), "DnsFlushResolverCacheEntry_A failed\n");
+    ok(!is_name_cached(L"test.winehq.org", DNS_TYPE_A), "name not flushed\n");
+
+    /* MaxCacheTtl bounds the lifetime of the entries */
+    ret = getaddrinfo("test.winehq.org", NULL, &hint, &result);
+    ok(!ret, "getaddrinfo failed with %d\n", ret);
+    freeaddrinfo(result);
+    ok(is_name_cached(L"test.winehq.org", DNS_TYPE_A), "name not cached\n");
+    Sleep(2500);
+    ok(!is_name_cached(L"test.winehq.org", DNS_TYPE_A), "name not expired\n");
+
+    /* numeric addresses have no TTL */
+    ret = getaddrinfo("127.0.0.1", NULL, &hint, &result);
+    ok(!ret, "getaddrinfo failed with %d\n", ret);
+    freeaddrinfo(result);
+    ok(!is_name_cached(L"127.0.0.1", DNS_TYPE_A), "numeric address cached\n");
+
+    result = NULL;
+    ret = getaddrinfo("nonexistent.winehq.org", NULL, &hint, &result);
+    /* Some ISPs resolve nonexistent host names to addresses of their spam pages. */
+    if (!ret)
+    {
+        skip("nonexistent.winehq.org was resolved\n");
+        freeaddrinfo(result);
+    }
+    else
+    {
+        ok(ret == WSAHOST_NOT_FOUND, "got %d\n", ret);
+        ok(!result, "got %p\n", result);
+        ok(is_name_cached(L"nonexistent.winehq.org", DNS_TYPE_A), "failed lookup not cached\n");
+
+        ret = getaddrinfo("nonexistent.winehq.org", NULL, &hint, &result);
+        ok(ret == WSAHOST_NOT_FOUND, "got %d\n", ret);
+        ok(!result, "got %p\n", result);
+
+        pDnsFlushResolverCache();
+        ok(!is_name_cached(L"nonexistent.winehq.org", DNS_TYPE_A), "failed lookup not flushed\n");
+    }
+
+    /* IDNs are cached and flushed by their punycode name */
+    memset(&hintW, 0, sizeof(hintW));
+    hintW.ai_family = AF_INET;
+    ret = GetAddrInfoW(idn_domain, NULL, &hintW, &resultW);
+    if (ret)
+    {
+        skip("%s can't be resolved, error %d\n", debugstr_w(idn_domain), ret);
+        return;
+    }
+    FreeAddrInfoW(resultW);
+    ok(is_name_cached(idn_punycode, DNS_TYPE_A), "name not cached\n");
+    ok(pDnsFlushResolverCacheEntry_W(idn_domain), "DnsFlushResolverCacheEntry_W failed\n");
+    ok(!is_name_cached(idn_punycode, DNS_TYPE_A), "name not flushed\n");
+}
+
+static void test_addrinfo_cache(void)
+{
+    static const WCHAR *values[] = { L"MaxCacheTtl", L"MaxNegativeCacheTtl" };
+    DWORD saved[ARRAY_SIZE(values)], size, value = 2;
+    BOOL exists[ARRAY_SIZE(values)];
+    STARTUPINFOA si = { 0 };
+    PROCESS_INFORMATION pi;
+    char cmdline[MAX_PATH];
+    unsigned int i;
+    char **argv;
+    LSTATUS status;
+    HKEY key;
+    BOOL ret;
+
+    /* Wine caches lookups per process, only when configured to */
+    if (strcmp(winetest_platform, "wine"))
+    {
+        skip("the resolver cache is a system service\n");
+        return;
+    }
+
+    status = RegCreateKeyExW(HKEY_LOCAL_MACHINE, L"System\\CurrentControlSet\\Services\\Dnscache\\Parameters",
+                             0, NULL, 0, KEY_QUERY_VALUE | KEY_SET_VALUE, NULL, &key, NULL);
+    if (status)
+    {
+        skip("can't configure the resolver cache, error %ld\n", status);
+        return;
+    }
+    for (i = 0; i < ARRAY_SIZE(values); i++)
+    {
+        size = sizeof(saved[i]);
+        exists[i] = !RegQueryValueExW(key, values[i], NULL, NULL, (BYTE *)&saved[i], &size);
+        status = RegSetValueExW(key, values[i], 0, REG_DWORD, (BYTE *)&value, sizeof(value));
+        ok(!status, "got %ld\n", status);
+    }
+
+    si.cb = sizeof(si);
+    winetest_get_mainargs(&argv);
+    sprintf(cmdline, "%s %s addrinfo_cache", argv[0], argv[1]);
+    ret = CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi);
+    ok(ret, "CreateProcess failed, error %lu\n", GetLastError());
+    if (ret)
+    {
+        wait_child_process(pi.hProcess);
+        CloseHandle(pi.hProcess);
+        CloseHandle(pi.hThread);
+    }
+
+    for (i = 0; i < ARRAY_SIZE(values); i++)
+    {
+        if (exists[i]) RegSetValueExW(key, values[i], 0, REG_DWORD, (BYTE *)&saved[i], sizeof(saved[i]));
+        else RegDeleteValueW(key, values[i]);
+    }
+    RegCloseKey(key);
+}
+
 static void test_dns(void)
 {
     struct hostent *h;
@@ -3041,7 +3206,8 @@ static void test_startup(void)
 START_TEST( protocol )
 {
     WSADATA data;
-    int ret;
+    char **argv;
+    int argc, ret;
 
     pFreeAddrInfoExW = (void *)GetProcAddress(GetModuleHandleA("ws2_32"), "FreeAddrInfoExW");
     pGetAddrInfoExOverlappedResult = (void *)GetProcAddress(GetModuleHandleA("ws2_32"), "GetAddrInfoExOverlappedResult");
@@ -3056,6 +3222,14 @@ START_TEST( protocol )
     ret = WSAStartup(0x202, &data);
     ok(!ret, "got %d\n", ret);
 
+    argc = winetest_get_mainargs(&argv);
+    if (argc >= 3 && !strcmp(argv[2], "addrinfo_cache"))
+    {
+        test_addrinfo_cache_child();
+        WSACleanup();
+        return;
+    }
+
     test_WSAEnumProtocolsA();
     test_WSAEnumProtocolsW();
     test_getprotobyname();
@@ -3074,6 +3248,7 @@ START_TEST( protocol )
     test_GetAddrInfoW();
     test_GetAddrInfoExW();
     test_getaddrinfo();
+    test_addrinfo_cache();
 
     test_dns();
     test_gethostbyname();
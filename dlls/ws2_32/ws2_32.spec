@@ -135,3 +135,5 @@
 @ stdcall getnameinfo(ptr long ptr long ptr long long)
 @ stdcall inet_ntop(long ptr ptr long)
 @ stdcall inet_pton(long str ptr)
+@ stdcall __wine_enum_addrinfo_cache(ptr ptr)
+@ stdcall __wine_flush_addrinfo_cache(str)
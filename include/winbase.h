@@ -3052,6 +3052,27 @@ static FORCEINLINE HANDLE WINAPI GetCurrentThreadEffectiveToken(void)
     return (HANDLE)~(ULONG_PTR)5;
 }
 
+static FORCEINLINE void WINAPI InitializeThreadpoolEnvironment( PTP_CALLBACK_ENVIRON env )
+{
+    TpInitializeCallbackEnviron( env );
+}
+
+static FORCEINLINE void WINAPI SetThreadpoolCallbackPool( PTP_CALLBACK_ENVIRON env, PTP_POOL pool )
+{
+    TpSetCallbackThreadpool( env, pool );
+}
+
+static FORCEINLINE void WINAPI SetThreadpoolCallbackCleanupGroup( PTP_CALLBACK_ENVIRON env, PTP_CLEANUP_GROUP group,
+                                                                  PTP_CLEANUP_GROUP_CANCEL_CALLBACK cancel )
+{
+    TpSetCallbackCleanupGroup( env, group, cancel );
+}
+
+static FORCEINLINE void WINAPI DestroyThreadpoolEnvironment( PTP_CALLBACK_ENVIRON env )
+{
+    TpDestroyCallbackEnviron( env );
+}
+
 /* WinMain(entry point) must be declared in winbase.h. */
 /* If this is not declared, we cannot compile many sources written with C++. */
 int WINAPI WinMain(HINSTANCE,HINSTANCE,LPSTR,int);
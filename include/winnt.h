@@ -6690,6 +6690,34 @@ typedef VOID (CALLBACK *PTP_WORK_CALLBACK)(PTP_CALLBACK_INSTANCE,PVOID,PTP_WORK)
 typedef VOID (CALLBACK *PTP_TIMER_CALLBACK)(PTP_CALLBACK_INSTANCE,PVOID,PTP_TIMER);
 typedef VOID (CALLBACK *PTP_WAIT_CALLBACK)(PTP_CALLBACK_INSTANCE,PVOID,PTP_WAIT,TP_WAIT_RESULT);
 
+static FORCEINLINE void TpInitializeCallbackEnviron( PTP_CALLBACK_ENVIRON env )
+{
+    env->Version = 1;
+    env->Pool = NULL;
+    env->CleanupGroup = NULL;
+    env->CleanupGroupCancelCallback = NULL;
+    env->RaceDll = NULL;
+    env->ActivationContext = NULL;
+    env->FinalizationCallback = NULL;
+    env->u.Flags = 0;
+}
+
+static FORCEINLINE void TpSetCallbackThreadpool( PTP_CALLBACK_ENVIRON env, PTP_POOL pool )
+{
+    env->Pool = pool;
+}
+
+static FORCEINLINE void TpSetCallbackCleanupGroup( PTP_CALLBACK_ENVIRON env, PTP_CLEANUP_GROUP group,
+                                                   PTP_CLEANUP_GROUP_CANCEL_CALLBACK cancel )
+{
+    env->CleanupGroup = group;
+    env->CleanupGroupCancelCallback = cancel;
+}
+
+static FORCEINLINE void TpDestroyCallbackEnviron( PTP_CALLBACK_ENVIRON env )
+{
+}
+
 
 NTSYSAPI BOOLEAN NTAPI RtlGetProductInfo(DWORD,DWORD,DWORD,DWORD,PDWORD);
 